@@ -0,0 +1,177 @@
+//
+// Counts heap allocations made on the request/response hot path.
+//
+// Usage: benchmark_allocations [iterations] [uri]
+// Without uri the responses are read from temporary files through file:// scheme,
+// so no server is needed and only the client side is measured.
+//
+
+#include "marzbanpp/api_requests.h"
+#include "marzbanpp/parse_response.h"
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+std::atomic<size_t> allocated_bytes{0};
+
+struct Counters {
+  size_t allocations;
+  size_t bytes;
+};
+
+Counters Now() noexcept {
+  return {allocations.load(std::memory_order_relaxed), allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+void Measure(std::string_view name, size_t iterations, const std::function<void()>& operation) {
+  // warming up: pooled handles, connections and headers are created here
+  operation();
+
+  const auto before = Now();
+  const auto started = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < iterations; ++i) {
+    operation();
+  }
+
+  const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started);
+  const auto after = Now();
+
+  fmt::print(
+    "{:<36} {:>10.1f} allocs/op {:>12.1f} bytes/op {:>10.2f} us/op\n",
+    name,
+    static_cast<double>(after.allocations - before.allocations) / static_cast<double>(iterations),
+    static_cast<double>(after.bytes - before.bytes) / static_cast<double>(iterations),
+    elapsed.count() / static_cast<double>(iterations));
+}
+
+//
+// file:// transfers have no status code, so successful reads are given 200 to pass the usual checks.
+//
+template <typename T>
+T Parse(marzbanpp::HttpClient::Response response) {
+  if (response.status_code == 0) {
+    response.status_code = 200;
+  }
+
+  return marzbanpp::ParseResponse<T>(std::move(response));
+}
+
+struct BillingUser {
+  std::optional<std::string> username;
+  std::optional<uint64_t> used_traffic;
+};
+
+marzbanpp::User MakeUser(size_t index) {
+  marzbanpp::User user;
+  user.username = fmt::format("user_{:06}", index);
+  user.status = marzbanpp::status_values::kActive;
+  user.data_limit = 100ULL * 1024 * 1024 * 1024;
+  user.used_traffic = index * 1024 * 1024;
+  user.note = "created by allocations benchmark";
+  user.inbounds = marzbanpp::User::Inbounds{{"VLESS TCP REALITY"}, {"Shadowsocks TCP"}};
+  user.links = {fmt::format("vless://{}@example.com:443", index)};
+
+  return user;
+}
+
+//
+// Writes files answering GetUser and GetUsers requests built for the returned uri.
+//
+std::string WriteResponses() {
+  const auto root = std::filesystem::temp_directory_path() / "marzbanpp_allocations_benchmark";
+  std::filesystem::create_directories(root / "api" / "user");
+
+  marzbanpp::Users users;
+
+  for (size_t i = 0; i < 100; ++i) {
+    users.users.push_back(MakeUser(i));
+  }
+
+  users.total = users.users.size();
+
+  std::string json;
+  (void) glz::write_json(users, json);
+  std::ofstream{root / "api" / "users"} << json;
+
+  json.clear();
+  (void) glz::write_json(users.users.front(), json);
+  std::ofstream{root / "api" / "user" / "user_000000"} << json;
+
+  return "file://" + root.string();
+}
+
+}// namespace
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+  if (void* pointer = std::malloc(size ? size : 1)) {
+    return pointer;
+  }
+
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
+
+int main(int argc, char** argv) {
+  const size_t iterations = argc > 1 ? std::stoull(argv[1]) : 10000;
+  const std::string uri = argc > 2 ? argv[2] : WriteResponses();
+
+  const marzbanpp::ApiRequests requests{uri, "Bearer", std::string(180, 'x')};
+  const marzbanpp::HttpClient client;
+  const auto user = MakeUser(0);
+
+  Measure("build GetUser request", iterations, [&]() {
+    const auto request = requests.GetUser("user_000000");
+  });
+
+  Measure("build ModifyUser request", iterations, [&]() {
+    const auto request = requests.ModifyUser("user_000000", user);
+  });
+
+  Measure("GetUser round trip", iterations, [&]() {
+    const auto parsed = Parse<marzbanpp::User>(client.Perform(requests.GetUser("user_000000")));
+  });
+
+  Measure("GetUsers (100 users) round trip", iterations / 10 + 1, [&]() {
+    const auto parsed = Parse<marzbanpp::Users>(client.Perform(requests.GetUsers()));
+  });
+
+  Measure("GetUsers (100 users) projected", iterations / 10 + 1, [&]() {
+    const auto response = client.Perform(requests.GetUsers());
+
+    marzbanpp::UsersOf<BillingUser> parsed{};
+    (void) glz::read<glz::opts{.error_on_unknown_keys = false}>(parsed, response.body);
+  });
+
+  Measure("failed response to exception", iterations, [&]() {
+    marzbanpp::HttpClient::Response response;
+    response.status_code = 404;
+    response.body = R"({"detail":"User not found"})";
+
+    try {
+      marzbanpp::CheckResponse(std::move(response));
+    } catch (const marzbanpp::MarzbanServerResponseError&) {
+    }
+  });
+
+  Measure("failed response to ApiError", iterations, [&]() {
+    marzbanpp::HttpClient::Response response;
+    response.status_code = 404;
+    response.body = R"({"detail":"User not found"})";
+
+    const auto result = marzbanpp::TryParseResponse<marzbanpp::User>(std::move(response));
+    (void) result.error().NotFound();
+  });
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+//
+// Compares HTTP/1.1 connection pool with HTTP/2 multiplexing at 1, 16 and 256 concurrent callers.
+//
+// Usage: benchmark_http2 uri [seconds]
+// uri must be served over HTTP/2: https:// (negotiated by ALPN) or http:// with h2c prior knowledge.
+// The in-process mock panel isn't used here: it speaks only HTTP/1.1.
+//
+
+#include "marzbanpp/net/http_client.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::array kCallers{size_t{1}, size_t{16}, size_t{256}};
+// connections per host in HTTP/2 mode
+constexpr size_t kMaxHostConnections = 2;
+
+void Run(
+  std::string_view name,
+  marzbanpp::HttpClient::Options options,
+  const marzbanpp::HttpRequest& request,
+  size_t callers,
+  Clock::duration duration) {
+  const auto metrics = std::make_shared<marzbanpp::Metrics>();
+  options.metrics = metrics;
+
+  const marzbanpp::HttpClient client{options};
+  marzbanpp::LatencyHistogram latency;
+  std::atomic<uint64_t> errors{0};
+
+  const auto started = Clock::now();
+  const auto deadline = started + duration;
+
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(callers);
+
+    for (size_t i = 0; i < callers; ++i) {
+      threads.emplace_back([&]() {
+        while (Clock::now() < deadline) {
+          const auto call_started = Clock::now();
+
+          try {
+            if (client.Perform(request).status_code >= 400) {
+              errors.fetch_add(1, std::memory_order_relaxed);
+            }
+          } catch (const std::exception&) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+          }
+
+          latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - call_started));
+        }
+      });
+    }
+  }
+
+  const auto elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+  const auto snapshot = latency.Take();
+  const auto endpoint = metrics->Take().endpoints[std::string{request.endpoint}];
+
+  fmt::print(
+    "{:<22} {:>4} callers {:>10.0f} req/s  p50 {:>8} p99 {:>8}  connections {:>4}  errors {}\n",
+    name,
+    callers,
+    static_cast<double>(snapshot.count) / elapsed,
+    snapshot.Percentile(0.5),
+    snapshot.Percentile(0.99),
+    endpoint.new_connections,
+    errors.load());
+}
+
+}// namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fmt::print("usage: benchmark_http2 uri [seconds]\n");
+    return 1;
+  }
+
+  const auto duration = std::chrono::seconds{argc > 2 ? std::stoull(argv[2]) : 3};
+
+  marzbanpp::HttpRequest request;
+  request.endpoint = "benchmark";
+  request.uri = argv[1];
+
+  // plain http can only be HTTP/2 with prior knowledge, https negotiates it
+  const auto http2 = request.uri.starts_with("http://")
+                       ? marzbanpp::HttpClient::HttpVersion::kHttp2PriorKnowledge
+                       : marzbanpp::HttpClient::HttpVersion::kHttp2;
+
+  for (const auto callers : kCallers) {
+    Run(
+      "HTTP/1.1 pooled",
+      {.max_idle_handles = callers, .http_version = marzbanpp::HttpClient::HttpVersion::kHttp11},
+      request,
+      callers,
+      duration);
+
+    Run(
+      "HTTP/2 multiplexed",
+      {.http_version = http2, .max_host_connections = kMaxHostConnections},
+      request,
+      callers,
+      duration);
+  }
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+//
+// End-to-end load test of Api and ApiDecorator against the in-process mock panel.
+//
+// Usage: benchmark_load [callers] [seconds] [users] [latency_us] [error_rate]
+// Every caller thread sends GetUser (80%), GetUsers of 100 users (10%) and GetSystemStats (10%)
+// back to back; throughput and latency percentiles are printed for every api flavour.
+//
+
+#ifdef _WIN32
+
+int main() {
+  fmt::print("benchmark_load needs POSIX sockets and isn't supported on Windows\n");
+  return 0;
+}
+
+#else
+
+#include "marzbanpp/api.h"
+#include "marzbanpp/api_decorator.h"
+#include "marzbanpp/net/metrics.h"
+#include "marzbanpp/retrying_api.h"
+#include "mock_marzban_server.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadOptions {
+  size_t callers = 16;
+  Clock::duration duration = std::chrono::seconds{5};
+  size_t users = 10'000;
+};
+
+void Run(std::string_view name, const marzbanpp::IApi::Ptr& api, const LoadOptions& options) {
+  marzbanpp::LatencyHistogram latency;
+  std::atomic<uint64_t> errors{0};
+
+  const auto started = Clock::now();
+  const auto deadline = started + options.duration;
+
+  {
+    std::vector<std::jthread> callers;
+    callers.reserve(options.callers);
+
+    for (size_t caller = 0; caller < options.callers; ++caller) {
+      callers.emplace_back([&, caller]() {
+        std::mt19937_64 random{caller};
+
+        while (Clock::now() < deadline) {
+          const auto operation = random() % 10;
+          const auto call_started = Clock::now();
+
+          try {
+            if (operation == 0) {
+              marzbanpp::IApi::GetUsersParams params;
+              params.offset = random() % std::max<size_t>(options.users, 1);
+              params.limit = 100;
+              (void) api->GetUsers(params);
+            } else if (operation == 1) {
+              (void) api->GetSystemStats();
+            } else {
+              (void) api->GetUser(fmt::format("user_{:08}", random() % std::max<size_t>(options.users, 1)));
+            }
+          } catch (const std::exception&) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+          }
+
+          latency.Record(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - call_started));
+        }
+      });
+    }
+  }
+
+  const auto elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+  const auto snapshot = latency.Take();
+
+  fmt::print(
+    "{:<28} {:>10.0f} calls/s  p50 {:>8} p90 {:>8} p99 {:>8} p99.9 {:>8} max {:>8}  errors {}\n",
+    name,
+    static_cast<double>(snapshot.count) / elapsed,
+    snapshot.Percentile(0.5),
+    snapshot.Percentile(0.9),
+    snapshot.Percentile(0.99),
+    snapshot.Percentile(0.999),
+    snapshot.max,
+    errors.load());
+}
+
+}// namespace
+
+int main(int argc, char** argv) {
+  LoadOptions options;
+  marzbanpp::benchmarks::MockMarzbanServer::Options server_options;
+
+  if (argc > 1) {
+    options.callers = std::stoull(argv[1]);
+  }
+
+  if (argc > 2) {
+    options.duration = std::chrono::seconds{std::stoull(argv[2])};
+  }
+
+  if (argc > 3) {
+    options.users = std::stoull(argv[3]);
+  }
+
+  if (argc > 4) {
+    server_options.latency = std::chrono::microseconds{std::stoull(argv[4])};
+  }
+
+  if (argc > 5) {
+    server_options.error_rate = std::stod(argv[5]);
+  }
+
+  server_options.users = options.users;
+
+  const marzbanpp::benchmarks::MockMarzbanServer server{server_options};
+  const auto uri = server.Uri();
+
+  fmt::print(
+    "mock panel at {}: {} users, {} latency, {:.1f}% errors; {} callers\n",
+    uri,
+    server_options.users,
+    server_options.latency,
+    server_options.error_rate * 100,
+    options.callers);
+
+  const auto client = std::make_shared<marzbanpp::HttpClient>(
+    marzbanpp::HttpClient::Options{.max_idle_handles = std::max<size_t>(options.callers, 16)});
+
+  const auto decorator = std::make_shared<marzbanpp::ApiDecorator>(uri, "admin", "admin", client);
+
+  Run("Api", marzbanpp::Api::AuthAndCreate(uri, "admin", "admin", client), options);
+  Run("ApiDecorator", decorator, options);
+  Run("RetryingApi(ApiDecorator)", std::make_shared<marzbanpp::RetryingApi>(decorator), options);
+
+  fmt::print("mock panel has served {} requests\n", server.Requests());
+
+  return 0;
+}
+
+#endif
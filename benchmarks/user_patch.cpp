@@ -0,0 +1,130 @@
+//
+// Measures MakeUserPatch, which Reconciler::Plan runs for every desired user, and checks the patches
+// it builds before measuring: the benchmark fails if a patch would reset fields on the panel.
+//
+// Usage: benchmark_user_patch [users]
+//
+
+#include "marzbanpp/user_patch.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+marzbanpp::User MakeUser(size_t index) {
+  marzbanpp::User user;
+  user.username = fmt::format("user_{:08}", index);
+  user.status = marzbanpp::status_values::kActive;
+  user.expire = 1'700'000'000 + index;
+  user.data_limit = 100ULL * 1024 * 1024 * 1024;
+  user.used_traffic = index * 1024 * 1024;
+  user.note = "synthetic user";
+  user.proxies = marzbanpp::User::Proxies{
+    .vless = marzbanpp::User::Proxies::Vless{.flow = "", .id = fmt::format("{:08x}-0000-4000-8000-000000000000", index)},
+    .shadowsocks = marzbanpp::User::Proxies::Shadowsocks{.password = fmt::format("{:016x}", index), .method = "aes-128-gcm"},
+  };
+  user.inbounds = marzbanpp::User::Inbounds{{"VLESS TCP REALITY", "VLESS GRPC"}, {"Shadowsocks TCP"}};
+
+  return user;
+}
+
+bool Check(std::string_view name, bool passed) {
+  if (!passed) {
+    fmt::print(stderr, "check failed: {}\n", name);
+  }
+
+  return passed;
+}
+
+bool CheckPatches() {
+  const auto live = MakeUser(1);
+  bool passed = true;
+
+  {
+    auto desired = live;
+    desired.used_traffic = 0;
+    desired.inbounds = marzbanpp::User::Inbounds{{"VLESS GRPC", "VLESS TCP REALITY"}, {"Shadowsocks TCP"}};
+
+    passed &= Check("read-only fields and order of inbounds are ignored", marzbanpp::MakeUserPatch(live, desired).Empty());
+  }
+
+  {
+    // only the flow is known, as it is in a desired state kept elsewhere
+    marzbanpp::User desired;
+    desired.username = live.username;
+    desired.proxies = marzbanpp::User::Proxies{.vless = marzbanpp::User::Proxies::Vless{.flow = "xtls-rprx-vision"}};
+
+    const auto patch = marzbanpp::MakeUserPatch(live, desired);
+    const auto& proxies = patch.user.proxies;
+
+    passed &= Check("changed proxies are listed alone", patch.fields == std::vector<std::string_view>{"proxies"});
+    passed &= Check("changed flow is sent", proxies && proxies->vless && proxies->vless->flow == "xtls-rprx-vision");
+    passed &= Check("vless id is kept", proxies && proxies->vless && proxies->vless->id == live.proxies->vless->id);
+    passed &= Check("shadowsocks is kept", proxies && proxies->shadowsocks
+                                             && proxies->shadowsocks->password == live.proxies->shadowsocks->password
+                                             && proxies->shadowsocks->method == live.proxies->shadowsocks->method);
+  }
+
+  {
+    // inbounds of one protocol only, the others are left to the panel
+    marzbanpp::User desired;
+    desired.username = live.username;
+    desired.inbounds = marzbanpp::User::Inbounds{{"VLESS TCP REALITY", "VLESS GRPC"}, {}};
+
+    passed &= Check("empty protocol inbounds are unset", marzbanpp::MakeUserPatch(live, desired).Empty());
+
+    desired.inbounds->vless = {"VLESS GRPC"};
+
+    const auto patch = marzbanpp::MakeUserPatch(live, desired);
+    const auto& inbounds = patch.user.inbounds;
+
+    passed &= Check("changed vless inbounds are sent", inbounds && inbounds->vless == desired.inbounds->vless);
+    passed &= Check("shadowsocks inbounds are kept", inbounds && inbounds->shadowsocks == live.inbounds->shadowsocks);
+  }
+
+  {
+    auto desired = live;
+    desired.expire = *live.expire + 86400;
+
+    const auto patch = marzbanpp::MakeUserPatch(live, desired);
+    passed &= Check("only expire is sent", patch.fields == std::vector<std::string_view>{"expire"}
+                                             && !patch.user.proxies && !patch.user.inbounds && !patch.user.note);
+  }
+
+  return passed;
+}
+
+}// namespace
+
+int main(int argc, char** argv) {
+  if (!CheckPatches()) {
+    return 1;
+  }
+
+  const size_t count = argc > 1 ? std::stoull(argv[1]) : 100'000;
+
+  std::vector<marzbanpp::User> live;
+  std::vector<marzbanpp::User> desired;
+  live.reserve(count);
+  desired.reserve(count);
+
+  // every tenth user is extended, the rest are unchanged
+  for (size_t i = 0; i < count; ++i) {
+    live.push_back(MakeUser(i));
+    desired.push_back(live.back());
+
+    if (i % 10 == 0) {
+      *desired.back().expire += 86400;
+    }
+  }
+
+  size_t changed = 0;
+  const auto started = Clock::now();
+
+  for (size_t i = 0; i < count; ++i) {
+    changed += marzbanpp::MakeUserPatch(live[i], desired[i]).Empty() ? 0 : 1;
+  }
+
+  const auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - started).count();
+  fmt::print("MakeUserPatch: {} users, {} changed, {:.3f} us/user\n", count, changed, elapsed / static_cast<double>(count));
+}
@@ -0,0 +1,105 @@
+//
+// Compares scans over std::vector<User> with the same queries over UserTable columns.
+//
+// Usage: benchmark_user_table [rows]
+//
+
+#include "marzbanpp/user_table.h"
+
+namespace {
+
+constexpr uint64_t kExpireFrom = 1'700'000'000 + 100 * 86400;
+constexpr uint64_t kExpireTo = kExpireFrom + 86400;
+
+std::vector<marzbanpp::User> MakeUsers(size_t count) {
+  std::mt19937_64 random{42};
+  std::vector<marzbanpp::User> users(count);
+
+  constexpr std::array statuses{
+    marzbanpp::status_values::kActive,
+    marzbanpp::status_values::kOnHold,
+    marzbanpp::status_values::kDisabled,
+    marzbanpp::status_values::kLimited,
+    marzbanpp::status_values::kExpired};
+
+  for (size_t i = 0; i < count; ++i) {
+    auto& user = users[i];
+    user.username = fmt::format("user_{:08}", i);
+    user.status = std::string{statuses[random() % statuses.size()]};
+    user.data_limit = random() % 4 == 0 ? 0 : (random() % 100 + 1) * 1'000'000'000;
+    user.used_traffic = random() % 100'000'000'000;
+    user.lifetime_used_traffic = *user.used_traffic + random() % 100'000'000'000;
+    user.expire = 1'700'000'000 + random() % (365 * 86400);
+    user.admin = marzbanpp::Admin{.username = fmt::format("admin_{}", random() % 16)};
+  }
+
+  return users;
+}
+
+template <typename F>
+void Measure(std::string_view name, const F& operation) {
+  // warming up caches
+  auto result = operation();
+
+  const auto started = std::chrono::steady_clock::now();
+  result = operation();
+  const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started);
+
+  fmt::print("{:<44} {:>12} {:>10.2f} ms\n", name, result, elapsed.count());
+}
+
+}// namespace
+
+int main(int argc, char** argv) {
+  const size_t rows = argc > 1 ? std::stoull(argv[1]) : 1'000'000;
+
+  const auto users = MakeUsers(rows);
+  const auto started = std::chrono::steady_clock::now();
+  const marzbanpp::UserTable table{users};
+  const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started);
+
+  fmt::print("built table of {} rows in {:.2f} ms\n", table.Size(), elapsed.count());
+  fmt::print("User size {} bytes, table row size {} bytes\n\n",
+    sizeof(marzbanpp::User),
+    sizeof(uint64_t) * 4 + sizeof(marzbanpp::UserStatus) + sizeof(marzbanpp::UserTable::AdminId) + sizeof(uint32_t));
+
+  Measure("vector<User>: traffic >= 90% of limit", [&]() {
+    return std::ranges::count_if(users, [](const marzbanpp::User& user) {
+      return user.data_limit.value_or(0) != 0 && *user.used_traffic * 100 >= *user.data_limit * 90;
+    });
+  });
+
+  Measure("UserTable: traffic >= 90% of limit", [&]() {
+    return marzbanpp::UserTable::Count(table.TrafficUsedAtLeast(90));
+  });
+
+  Measure("vector<User>: active, expiring in 24h", [&]() {
+    return std::ranges::count_if(users, [](const marzbanpp::User& user) {
+      return user.status == marzbanpp::status_values::kActive && user.expire >= kExpireFrom && user.expire < kExpireTo;
+    });
+  });
+
+  Measure("UserTable: active, expiring in 24h", [&]() {
+    auto mask = table.StatusIs(marzbanpp::UserStatus::kActive);
+    marzbanpp::UserTable::And(mask, table.ExpiresBetween(kExpireFrom, kExpireTo));
+    return marzbanpp::UserTable::Count(mask);
+  });
+
+  Measure("vector<User>: used traffic of admin_3", [&]() {
+    uint64_t sum = 0;
+
+    for (const auto& user : users) {
+      if (user.admin->username == "admin_3") {
+        sum += *user.used_traffic;
+      }
+    }
+
+    return sum;
+  });
+
+  Measure("UserTable: used traffic of admin_3", [&]() {
+    return marzbanpp::UserTable::Sum(table.UsedTraffic(), table.OwnedBy("admin_3"));
+  });
+
+  return 0;
+}
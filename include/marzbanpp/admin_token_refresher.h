@@ -0,0 +1,72 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+#include "marzbanpp/types/admin_token.h"
+
+namespace marzbanpp {
+
+//
+// Refreshes admin token of an IApi object shared by many threads.
+// Only one login request is sent at a time: callers which have got 401 with the same token
+// wait for the refresh started by the first of them instead of logging in again.
+//
+// Optionally the token is refreshed proactively, a bit before the moment
+// written in the 'exp' claim of the JWT access token.
+//
+class AdminTokenRefresher final {
+ public:
+  struct Options {
+    bool proactive = false;
+    std::chrono::seconds margin{60};// proactive refresh happens this long before the token expires
+  };
+
+  AdminTokenRefresher(
+    std::string uri,
+    std::string username,
+    std::string password,
+    HttpClient::Ptr http_client,
+    Options options);
+
+  AdminTokenRefresher(const AdminTokenRefresher&) = delete;
+  AdminTokenRefresher& operator=(const AdminTokenRefresher&) = delete;
+
+  //
+  // Requests a new token and remembers its expiration time.
+  //
+  AdminToken Login() const;
+
+  //
+  // Incremented every time the token is refreshed.
+  // Read it before a request to tell later whether the token it has been sent with is still current.
+  //
+  uint64_t Generation() const noexcept;
+
+  //
+  // Logs in and sets new token to the api unless it has already been refreshed after observed_generation.
+  //
+  void Refresh(IApi& api, uint64_t observed_generation) const;
+
+  //
+  // Does nothing unless proactive refresh is enabled and the token expires in less than margin.
+  //
+  void RefreshIfExpiring(IApi& api) const;
+
+  const HttpClient::Ptr& Client() const noexcept;
+
+ private:
+  bool Expiring() const noexcept;
+  void SetToken(IApi& api) const;
+
+ private:
+  std::string uri_;
+  std::string username_;
+  std::string password_;
+  HttpClient::Ptr http_client_;
+  Options options_;
+
+  mutable std::mutex refresh_mutex_;
+  mutable std::atomic<uint64_t> generation_;
+  mutable std::atomic<int64_t> expires_at_;// seconds since epoch, 0 if unknown
+};
+
+}// namespace marzbanpp
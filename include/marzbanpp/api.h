@@ -1,5 +1,6 @@
 #pragma once
 
+#include "marzbanpp/api_requests.h"
 #include "marzbanpp/iapi.h"
 #include "marzbanpp/types/admin_token.h"
 
@@ -12,11 +13,35 @@ class Api : public IApi {
     const std::string& username,
     const std::string& password);
 
+  static AdminToken GetAdminToken(
+    const HttpClient& http_client,
+    const std::string& uri,
+    const std::string& username,
+    const std::string& password);
+
   static Ptr AuthAndCreate(
     const std::string& uri,
     const std::string& username,
     const std::string& password);
 
+  //
+  // Created Api sends all requests through passed http_client.
+  // So the same connection pool can be shared by several Api objects.
+  //
+  static Ptr AuthAndCreate(
+    const std::string& uri,
+    const std::string& username,
+    const std::string& password,
+    HttpClient::Ptr http_client);
+
+  //
+  // Creates Api with already received token.
+  //
+  static Ptr Create(std::string uri, const AdminToken& token, HttpClient::Ptr http_client);
+
+  //
+  // Safe to call while other threads are sending requests through this object.
+  //
   void SetAdminToken(const AdminToken& token) override;
 
   Admin GetCurrentAdmin() const override;
@@ -37,19 +62,29 @@ class Api : public IApi {
   User ResetUserDataUsage(const std::string& username) const override;
   User RevokeUserSubscription(const std::string& username) const override;
   Users GetUsers(const GetUsersParams& params = {}) const override;
+  std::string GetUsersJson(const GetUsersParams& params = {}) const override;
+  uint64_t StreamUsers(const GetUsersParams& params, const UserCallback& callback) const override;
   HttpClient::Response ResetUsersDataUsage() const override;
   UserUsage GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const override;
+  UsersUsage GetUsersUsage(
+    const TimePoint& start,
+    const TimePoint& end = {},
+    const std::vector<std::string>& admins = {}) const override;
   User SetOwner(const std::string& username, const std::string& admin_username) const override;
   UserList GetExpiredUsers(const ExpiredUsersParams& params = {}) const override;
   UserList DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const override;
 
+  ApiResult<User> TryGetUser(const std::string& username) const override;
+  ApiResult<User> TryAddUser(const User& user) const override;
+  ApiResult<User> TryModifyUser(const std::string& username, const User& modified_user) const override;
+  ApiResult<void> TryRemoveUser(const std::string& username) const override;
+
  private:
-  Api(std::string uri, std::string token_type, std::string access_token);
+  Api(std::string uri, std::string token_type, std::string access_token, HttpClient::Ptr http_client);
 
  private:
-  std::string uri_;
-  std::string token_type_;
-  std::string access_token_;
+  ApiRequests requests_;
+  HttpClient::Ptr http_client_;
 };
 
 }// namespace marzbanpp
@@ -1,12 +1,26 @@
 #pragma once
 
+#include "marzbanpp/admin_token_refresher.h"
 #include "marzbanpp/iapi.h"
 
 namespace marzbanpp {
 
+//
+// ApiDecorator can be shared by many threads. When the token expires
+// only one of them logs in again, the others wait for it and retry with the new token.
+//
 class ApiDecorator : public IApi {
  public:
-  ApiDecorator(std::string uri, std::string token_type, std::string access_token);
+  using TokenOptions = AdminTokenRefresher::Options;
+
+  ApiDecorator(std::string uri, std::string username, std::string password);
+
+  ApiDecorator(
+    std::string uri,
+    std::string username,
+    std::string password,
+    HttpClient::Ptr http_client,
+    TokenOptions token_options = {});
 
   void SetAdminToken(const AdminToken& token) override;
 
@@ -28,16 +42,25 @@ class ApiDecorator : public IApi {
   User ResetUserDataUsage(const std::string& username) const override;
   User RevokeUserSubscription(const std::string& username) const override;
   Users GetUsers(const GetUsersParams& params = {}) const override;
+  std::string GetUsersJson(const GetUsersParams& params = {}) const override;
+  uint64_t StreamUsers(const GetUsersParams& params, const UserCallback& callback) const override;
   HttpClient::Response ResetUsersDataUsage() const override;
   UserUsage GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const override;
+  UsersUsage GetUsersUsage(
+    const TimePoint& start,
+    const TimePoint& end = {},
+    const std::vector<std::string>& admins = {}) const override;
   User SetOwner(const std::string& username, const std::string& admin_username) const override;
   UserList GetExpiredUsers(const ExpiredUsersParams& params = {}) const override;
   UserList DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const override;
 
+  ApiResult<User> TryGetUser(const std::string& username) const override;
+  ApiResult<User> TryAddUser(const User& user) const override;
+  ApiResult<User> TryModifyUser(const std::string& username, const User& modified_user) const override;
+  ApiResult<void> TryRemoveUser(const std::string& username) const override;
+
  private:
-  std::string uri_;
-  std::string username_;
-  std::string password_;
+  AdminTokenRefresher token_refresher_;
   IApi::Ptr api_;
 };
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "marzbanpp/net/http_client.h"
+
+namespace marzbanpp {
+
+//
+// Failed api call returned by the non-throwing Try* methods instead of MarzbanServerResponseError
+// or FromJsonToObjectError. It only keeps the response, the message is formatted on demand,
+// so checking the status of a routine failure (e.g. 404 for a missing user) costs nothing.
+//
+class ApiError {
+ public:
+  enum class Kind : uint8_t {
+    kStatus,// the server answered with a non 200 status or an empty body
+    kParse, // the body isn't valid JSON of the expected type
+  };
+
+  static ApiError Status(HttpClient::Response response) noexcept;
+  static ApiError Parse(const glz::error_ctx& error_ctx, HttpClient::Response response) noexcept;
+
+  Kind GetKind() const noexcept { return kind_; }
+  int StatusCode() const noexcept { return response_.status_code; }
+  bool NotFound() const noexcept { return kind_ == Kind::kStatus && response_.status_code == 404; }
+
+  const HttpClient::Response& Response() const& noexcept { return response_; }
+  HttpClient::Response&& Response() && noexcept { return std::move(response_); }
+
+  //
+  // The same text what() of the corresponding exception returns.
+  //
+  std::string Message() const;
+
+  //
+  // Throws the exception the throwing method would have thrown.
+  //
+  [[noreturn]] void Throw() &&;
+
+ private:
+  ApiError(Kind kind, const glz::error_ctx& error_ctx, HttpClient::Response response) noexcept;
+
+ private:
+  Kind kind_;
+  glz::error_ctx error_ctx_;
+  HttpClient::Response response_;
+};
+
+template <typename T>
+using ApiResult = std::expected<T, ApiError>;
+
+}// namespace marzbanpp
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+#include "marzbanpp/net/http_request.h"
+
+namespace marzbanpp {
+
+//
+// Builds HTTP requests for Marzban REST API endpoints.
+// Used by synchronous and asynchronous API implementations,
+// so both of them send exactly the same requests.
+//
+class ApiRequests final {
+ public:
+  using GetAdminsParams = IApi::GetAdminsParams;
+  using GetUsersParams = IApi::GetUsersParams;
+  using ExpiredUsersParams = IApi::ExpiredUsersParams;
+  using TimePoint = IApi::TimePoint;
+
+  ApiRequests(std::string uri, std::string token_type, std::string access_token);
+
+  static HttpRequest GetAdminToken(
+    const std::string& uri,
+    const std::string& username,
+    const std::string& password);
+
+  //
+  // Throws if user can't be passed to AddUser.
+  //
+  static void ValidateNewUser(const User& user);
+
+  //
+  // Throws if user can't be passed to ModifyUser.
+  //
+  static void ValidateModifiedUser(const User& user);
+
+  //
+  // Can be called while other threads are building requests.
+  //
+  void SetAdminToken(const AdminToken& token);
+
+  HttpRequest GetCurrentAdmin() const;
+  HttpRequest CreateAdmin(const Admin& admin) const;
+  HttpRequest ModifyAdmin(const std::string& username, const Admin& admin) const;
+  HttpRequest RemoveAdmin(const std::string& username) const;
+  HttpRequest GetAdmins(const GetAdminsParams& params = {}) const;
+
+  HttpRequest GetSystemStats() const;
+  HttpRequest GetInbounds() const;
+  HttpRequest GetHosts() const;
+  HttpRequest ModifyHosts(const Hosts& hosts) const;
+
+  HttpRequest AddUser(const User& user) const;
+  HttpRequest GetUser(const std::string& username) const;
+  HttpRequest ModifyUser(const std::string& username, const User& modified_user) const;
+  HttpRequest RemoveUser(const std::string& username) const;
+  HttpRequest ResetUserDataUsage(const std::string& username) const;
+  HttpRequest RevokeUserSubscription(const std::string& username) const;
+  HttpRequest GetUsers(const GetUsersParams& params = {}) const;
+  HttpRequest ResetUsersDataUsage() const;
+  HttpRequest GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const;
+  HttpRequest GetUsersUsage(
+    const TimePoint& start,
+    const TimePoint& end = {},
+    const std::vector<std::string>& admins = {}) const;
+  HttpRequest SetOwner(const std::string& username, const std::string& admin_username) const;
+  HttpRequest GetExpiredUsers(const ExpiredUsersParams& params = {}) const;
+  HttpRequest DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const;
+
+ private:
+  enum class ContentType {
+    kNone,
+    kJson,
+    kForm,
+  };
+
+  //
+  // Header lists are built once per token and shared by all requests.
+  //
+  struct AuthorizedHeaderLists {
+    HttpHeaders none;
+    HttpHeaders json;
+    HttpHeaders form;
+  };
+
+  static std::shared_ptr<const AuthorizedHeaderLists> MakeHeaderLists(const std::string& authorization);
+
+  HttpHeaders AuthorizedHeaders(ContentType content_type = ContentType::kNone) const;
+
+ private:
+  std::string uri_;
+  std::atomic<std::shared_ptr<const AuthorizedHeaderLists>> header_lists_;
+};
+
+}// namespace marzbanpp
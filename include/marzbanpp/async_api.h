@@ -0,0 +1,110 @@
+#pragma once
+
+#include "marzbanpp/api_requests.h"
+#include "marzbanpp/iapi.h"
+#include "marzbanpp/net/async_http_client.h"
+#include "marzbanpp/user_range.h"
+
+namespace marzbanpp {
+
+//
+// AsyncApi mirrors IApi but doesn't block the calling thread.
+// Every method has two forms: the first one returns std::future,
+// the second one takes a callback which is invoked on the AsyncHttpClient event loop thread.
+//
+// Errors (the same exceptions which Api throws) are passed to the future or to the callback.
+// Callbacks run on the event loop thread: they must not block and must not throw,
+// an exception escaping a callback is dropped.
+//
+class AsyncApi {
+ public:
+  using Ptr = std::shared_ptr<AsyncApi>;
+  using TimePoint = IApi::TimePoint;
+  using GetAdminsParams = IApi::GetAdminsParams;
+  using GetUsersParams = IApi::GetUsersParams;
+  using ExpiredUsersParams = IApi::ExpiredUsersParams;
+
+  template <typename T>
+  using Result = std::expected<T, std::exception_ptr>;
+
+  template <typename T>
+  using Callback = std::function<void(Result<T>&& result)>;
+
+  static Ptr AuthAndCreate(
+    const std::string& uri,
+    const std::string& username,
+    const std::string& password);
+
+  static Ptr AuthAndCreate(
+    const std::string& uri,
+    const std::string& username,
+    const std::string& password,
+    AsyncHttpClient::Ptr client);
+
+  void SetAdminToken(const AdminToken& token);
+
+  std::future<Admin> GetCurrentAdmin() const;
+  std::future<Admin> CreateAdmin(const Admin& admin) const;
+  std::future<Admin> ModifyAdmin(const std::string& username, const Admin& admin) const;
+  std::future<Admin> RemoveAdmin(const std::string& username) const;
+  std::future<Admins> GetAdmins(const GetAdminsParams& params = {}) const;
+
+  std::future<System> GetSystemStats() const;
+  std::future<Inbounds> GetInbounds() const;
+  std::future<Hosts> GetHosts() const;
+  std::future<Hosts> ModifyHosts(const Hosts& hosts) const;
+
+  std::future<User> AddUser(const User& user) const;
+  std::future<User> GetUser(const std::string& username) const;
+  std::future<User> ModifyUser(const std::string& username, const User& modified_user) const;
+  std::future<HttpClient::Response> RemoveUser(const std::string& username) const;
+  std::future<User> ResetUserDataUsage(const std::string& username) const;
+  std::future<User> RevokeUserSubscription(const std::string& username) const;
+  std::future<Users> GetUsers(const GetUsersParams& params = {}) const;
+  std::future<HttpClient::Response> ResetUsersDataUsage() const;
+  std::future<UserUsage> GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const;
+  std::future<User> SetOwner(const std::string& username, const std::string& admin_username) const;
+  std::future<UserList> GetExpiredUsers(const ExpiredUsersParams& params = {}) const;
+  std::future<UserList> DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const;
+
+  void GetCurrentAdmin(Callback<Admin> callback) const;
+  void CreateAdmin(const Admin& admin, Callback<Admin> callback) const;
+  void ModifyAdmin(const std::string& username, const Admin& admin, Callback<Admin> callback) const;
+  void RemoveAdmin(const std::string& username, Callback<Admin> callback) const;
+  void GetAdmins(const GetAdminsParams& params, Callback<Admins> callback) const;
+
+  void GetSystemStats(Callback<System> callback) const;
+  void GetInbounds(Callback<Inbounds> callback) const;
+  void GetHosts(Callback<Hosts> callback) const;
+  void ModifyHosts(const Hosts& hosts, Callback<Hosts> callback) const;
+
+  void AddUser(const User& user, Callback<User> callback) const;
+  void GetUser(const std::string& username, Callback<User> callback) const;
+  void ModifyUser(const std::string& username, const User& modified_user, Callback<User> callback) const;
+  void RemoveUser(const std::string& username, Callback<HttpClient::Response> callback) const;
+  void ResetUserDataUsage(const std::string& username, Callback<User> callback) const;
+  void RevokeUserSubscription(const std::string& username, Callback<User> callback) const;
+  void GetUsers(const GetUsersParams& params, Callback<Users> callback) const;
+  void ResetUsersDataUsage(Callback<HttpClient::Response> callback) const;
+  void GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end, Callback<UserUsage> callback) const;
+  void SetOwner(const std::string& username, const std::string& admin_username, Callback<User> callback) const;
+  void GetExpiredUsers(const ExpiredUsersParams& params, Callback<UserList> callback) const;
+  void DeleteExpiredUsers(const ExpiredUsersParams& params, Callback<UserList> callback) const;
+
+  //
+  // Iterates users page by page prefetching up to prefetch_depth pages concurrently.
+  // AsyncApi object must outlive returned range.
+  //
+  UserRange IterateUsers(const GetUsersParams& params = {}, uint64_t page_size = 500, size_t prefetch_depth = 2) const;
+
+  const AsyncHttpClient::Ptr& Client() const noexcept;
+
+ private:
+  AsyncApi(std::string uri, std::string token_type, std::string access_token, AsyncHttpClient::Ptr client);
+
+ private:
+  ApiRequests requests_;
+  AsyncHttpClient::Ptr client_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+struct BulkOptions {
+  size_t parallelism = 8;// number of requests sent concurrently
+};
+
+//
+// Result of a bulk operation: items[i] holds either the value returned for the i-th input item
+// or the exception it has failed with. Failed items don't stop processing of the others.
+//
+template <typename T>
+struct BulkResult {
+  using Item = std::expected<T, std::exception_ptr>;
+
+  std::vector<Item> items;
+  size_t succeeded = 0;
+  size_t failed = 0;
+  std::chrono::steady_clock::duration elapsed{};
+
+  double ItemsPerSecond() const noexcept {
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(items.size()) / seconds : 0.0;
+  }
+};
+
+struct UserModification {
+  std::string username;
+  User user;
+};
+
+struct OwnerAssignment {
+  std::string username;
+  std::string admin_username;
+};
+
+//
+// Users are validated the same way IApi::AddUser does it before any request is sent,
+// invalid users are reported as failed items and aren't sent at all.
+//
+BulkResult<User> BulkAddUsers(const IApi::Ptr& api, std::span<const User> users, const BulkOptions& options = {});
+
+BulkResult<User> BulkModifyUsers(
+  const IApi::Ptr& api,
+  std::span<const UserModification> modifications,
+  const BulkOptions& options = {});
+
+BulkResult<User> BulkSetOwners(
+  const IApi::Ptr& api,
+  std::span<const OwnerAssignment> assignments,
+  const BulkOptions& options = {});
+
+BulkResult<HttpClient::Response> BulkRemoveUsers(
+  const IApi::Ptr& api,
+  std::span<const std::string> usernames,
+  const BulkOptions& options = {});
+
+BulkResult<User> BulkResetUsersDataUsage(
+  const IApi::Ptr& api,
+  std::span<const std::string> usernames,
+  const BulkOptions& options = {});
+
+}// namespace marzbanpp
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "marzbanpp/async_api.h"
+#include "marzbanpp/coro/scheduler.h"
+#include "marzbanpp/coro/task.h"
+
+namespace marzbanpp {
+
+//
+// CoApi provides co_await-able versions of IApi operations on top of AsyncApi.
+// Coroutines waiting for responses are resumed through the passed scheduler.
+//
+// Arguments are taken by value because returned tasks are lazy and may be started
+// after the caller's temporaries are gone. CoApi object must outlive all tasks it has created.
+//
+class CoApi final {
+ public:
+  using Ptr = std::shared_ptr<CoApi>;
+  using TimePoint = IApi::TimePoint;
+  using GetAdminsParams = IApi::GetAdminsParams;
+  using GetUsersParams = IApi::GetUsersParams;
+  using ExpiredUsersParams = IApi::ExpiredUsersParams;
+
+  explicit CoApi(AsyncApi::Ptr api, IScheduler::Ptr scheduler = std::make_shared<InlineScheduler>());
+
+  Task<Admin> GetCurrentAdmin() const;
+  Task<Admin> CreateAdmin(Admin admin) const;
+  Task<Admin> ModifyAdmin(std::string username, Admin admin) const;
+  Task<Admin> RemoveAdmin(std::string username) const;
+  Task<Admins> GetAdmins(GetAdminsParams params = {}) const;
+
+  Task<System> GetSystemStats() const;
+  Task<Inbounds> GetInbounds() const;
+  Task<Hosts> GetHosts() const;
+  Task<Hosts> ModifyHosts(Hosts hosts) const;
+
+  Task<User> AddUser(User user) const;
+  Task<User> GetUser(std::string username) const;
+  Task<User> ModifyUser(std::string username, User modified_user) const;
+  Task<HttpClient::Response> RemoveUser(std::string username) const;
+  Task<User> ResetUserDataUsage(std::string username) const;
+  Task<User> RevokeUserSubscription(std::string username) const;
+  Task<Users> GetUsers(GetUsersParams params = {}) const;
+  Task<HttpClient::Response> ResetUsersDataUsage() const;
+  Task<UserUsage> GetUserUsage(std::string username, TimePoint start, TimePoint end = {}) const;
+  Task<User> SetOwner(std::string username, std::string admin_username) const;
+  Task<UserList> GetExpiredUsers(ExpiredUsersParams params = {}) const;
+  Task<UserList> DeleteExpiredUsers(ExpiredUsersParams params = {}) const;
+
+  const AsyncApi::Ptr& Api() const noexcept;
+  const IScheduler::Ptr& Scheduler() const noexcept;
+
+ private:
+  AsyncApi::Ptr api_;
+  IScheduler::Ptr scheduler_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// Decorator which merges identical concurrent reads: while a GetUser, GetUsers(Json), GetHosts, GetInbounds,
+// GetSystemStats or GetCurrentAdmin request is in flight, the same calls with the same arguments
+// wait for it and get a copy of its result (or its exception) instead of sending their own requests.
+// Nothing is cached: a call made after the request has completed sends a new one.
+// Other methods (including the non-throwing Try* ones) are forwarded to the wrapped api as is.
+//
+class CoalescingApi : public IApi {
+ public:
+  explicit CoalescingApi(IApi::Ptr api);
+
+  void SetAdminToken(const AdminToken& token) override;
+
+  Admin GetCurrentAdmin() const override;
+  Admin CreateAdmin(const Admin& admin) const override;
+  Admin ModifyAdmin(const std::string& username, const Admin& admin) const override;
+  Admin RemoveAdmin(const std::string& username) const override;
+  Admins GetAdmins(const GetAdminsParams& params = {}) const override;
+
+  System GetSystemStats() const override;
+  Inbounds GetInbounds() const override;
+  Hosts GetHosts() const override;
+  Hosts ModifyHosts(const Hosts& hosts) const override;
+
+  User AddUser(const User& user) const override;
+  User GetUser(const std::string& username) const override;
+  User ModifyUser(const std::string& username, const User& modified_user) const override;
+  HttpClient::Response RemoveUser(const std::string& username) const override;
+  User ResetUserDataUsage(const std::string& username) const override;
+  User RevokeUserSubscription(const std::string& username) const override;
+  Users GetUsers(const GetUsersParams& params = {}) const override;
+  std::string GetUsersJson(const GetUsersParams& params = {}) const override;
+  uint64_t StreamUsers(const GetUsersParams& params, const UserCallback& callback) const override;
+  HttpClient::Response ResetUsersDataUsage() const override;
+  UserUsage GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const override;
+  UsersUsage GetUsersUsage(
+    const TimePoint& start,
+    const TimePoint& end = {},
+    const std::vector<std::string>& admins = {}) const override;
+  User SetOwner(const std::string& username, const std::string& admin_username) const override;
+  UserList GetExpiredUsers(const ExpiredUsersParams& params = {}) const override;
+  UserList DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const override;
+
+  ApiResult<User> TryGetUser(const std::string& username) const override;
+  ApiResult<User> TryAddUser(const User& user) const override;
+  ApiResult<User> TryModifyUser(const std::string& username, const User& modified_user) const override;
+  ApiResult<void> TryRemoveUser(const std::string& username) const override;
+
+ private:
+  template <typename T>
+  struct Request {
+    std::shared_future<T> result;
+    size_t waiters = 0;// the result is copied to the future only if somebody waits for it
+  };
+
+  template <typename T>
+  struct InFlight {
+    std::mutex mutex;
+    std::unordered_map<std::string, Request<T>> requests;
+  };
+
+  template <typename T>
+  static T Coalesce(InFlight<T>& in_flight, const std::string& key, const auto& call);
+
+ private:
+  IApi::Ptr api_;
+
+  mutable InFlight<Admin> admins_;
+  mutable InFlight<System> system_;
+  mutable InFlight<Inbounds> inbounds_;
+  mutable InFlight<Hosts> hosts_;
+  mutable InFlight<User> users_;
+  mutable InFlight<Users> user_pages_;
+  mutable InFlight<std::string> user_pages_json_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,63 @@
+#pragma once
+
+namespace marzbanpp {
+
+//
+// Decides where coroutines waiting for responses are resumed.
+// Implement this interface to resume coroutines on your own executor.
+//
+class IScheduler {
+ public:
+  using Ptr = std::shared_ptr<IScheduler>;
+
+  virtual void Schedule(std::coroutine_handle<> handle) = 0;
+
+  virtual ~IScheduler() = default;
+};
+
+//
+// Resumes coroutines right on the thread which has completed the operation
+// (for CoApi it's the AsyncHttpClient event loop thread).
+//
+class InlineScheduler final : public IScheduler {
+ public:
+  void Schedule(std::coroutine_handle<> handle) override;
+};
+
+//
+// Resumes coroutines on a fixed number of worker threads.
+// The destructor waits until all already scheduled coroutines have been resumed.
+//
+class ThreadPoolScheduler final : public IScheduler {
+ public:
+  explicit ThreadPoolScheduler(size_t threads = std::thread::hardware_concurrency());
+  ~ThreadPoolScheduler();
+
+  void Schedule(std::coroutine_handle<> handle) override;
+
+ private:
+  void Run(std::stop_token stop_token);
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable_any condition_;
+  std::deque<std::coroutine_handle<>> queue_;
+  std::vector<std::jthread> threads_;
+};
+
+//
+// Awaiting the result of this function moves the coroutine to the specified scheduler.
+//
+inline auto ScheduleOn(IScheduler& scheduler) noexcept {
+  struct Awaiter {
+    IScheduler& scheduler;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const { scheduler.Schedule(handle); }
+    void await_resume() const noexcept {}
+  };
+
+  return Awaiter{scheduler};
+}
+
+}// namespace marzbanpp
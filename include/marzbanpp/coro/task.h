@@ -0,0 +1,314 @@
+#pragma once
+
+namespace marzbanpp {
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+ public:
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      const auto continuation = handle.promise().continuation_;
+      return continuation ? continuation : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+
+  void unhandled_exception() noexcept { exception_ = std::current_exception(); }
+
+  void SetContinuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+
+ protected:
+  void RethrowIfFailed() const {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+ private:
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+};
+
+template <typename T>
+class TaskPromise final : public TaskPromiseBase {
+ public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& value) { value_.emplace(std::forward<U>(value)); }
+
+  T Result() {
+    RethrowIfFailed();
+    return std::move(*value_);
+  }
+
+ private:
+  std::optional<T> value_;
+};
+
+template <>
+class TaskPromise<void> final : public TaskPromiseBase {
+ public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() const noexcept {}
+
+  void Result() const { RethrowIfFailed(); }
+};
+
+}// namespace detail
+
+//
+// Lazily started coroutine. It starts executing when it's awaited by another coroutine
+// and resumes the awaiting coroutine when it's finished.
+// Use SyncWait or StartAsFuture to run it from ordinary code.
+//
+template <typename T = void>
+class [[nodiscard]] Task final {
+ public:
+  using promise_type = detail::TaskPromise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task() noexcept = default;
+  explicit Task(Handle handle) noexcept : handle_{handle} {}
+
+  Task(Task&& other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      Destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() { Destroy(); }
+
+  auto operator co_await() && noexcept {
+    struct Awaiter {
+      Handle handle;
+
+      bool await_ready() const noexcept { return !handle || handle.done(); }
+
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().SetContinuation(awaiting);
+        return handle;
+      }
+
+      T await_resume() {
+        if (!handle) {
+          throw std::logic_error{"awaiting an empty Task"};
+        }
+
+        return handle.promise().Result();
+      }
+    };
+
+    return Awaiter{handle_};
+  }
+
+ private:
+  void Destroy() noexcept {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+ private:
+  Handle handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>{std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+//
+// Eagerly started coroutine which destroys itself when it's finished.
+//
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() const noexcept { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { std::terminate(); }
+  };
+};
+
+class WhenAllStateBase {
+ public:
+  explicit WhenAllStateBase(size_t count) : remaining_{count + 1} {}
+
+  void SetError(std::exception_ptr error) {
+    std::lock_guard _{mutex_};
+
+    if (!error_) {
+      error_ = std::move(error);
+    }
+  }
+
+  void SetContinuation(std::coroutine_handle<> continuation) noexcept { continuation_ = continuation; }
+
+  bool Arrive() noexcept { return remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+  void ResumeContinuation() const { continuation_.resume(); }
+
+ protected:
+  void RethrowIfFailed() const {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  std::atomic<size_t> remaining_;
+  std::mutex mutex_;
+  std::exception_ptr error_;
+  std::coroutine_handle<> continuation_;
+};
+
+template <typename T>
+class WhenAllState final : public WhenAllStateBase {
+ public:
+  explicit WhenAllState(size_t count) : WhenAllStateBase{count}, results_(count) {}
+
+  template <typename U>
+  void SetResult(size_t index, U&& value) { results_[index].emplace(std::forward<U>(value)); }
+
+  std::vector<T> Result() {
+    RethrowIfFailed();
+
+    std::vector<T> results;
+    results.reserve(results_.size());
+
+    for (auto& result : results_) {
+      results.push_back(std::move(*result));
+    }
+
+    return results;
+  }
+
+ private:
+  std::vector<std::optional<T>> results_;
+};
+
+template <>
+class WhenAllState<void> final : public WhenAllStateBase {
+ public:
+  using WhenAllStateBase::WhenAllStateBase;
+
+  void Result() const { RethrowIfFailed(); }
+};
+
+template <typename T>
+using WhenAllResult = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+template <typename T>
+DetachedTask RunWhenAllTask(Task<T>& task, size_t index, std::shared_ptr<WhenAllState<T>> state) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      co_await std::move(task);
+    } else {
+      state->SetResult(index, co_await std::move(task));
+    }
+  } catch (...) {
+    state->SetError(std::current_exception());
+  }
+
+  if (state->Arrive()) {
+    state->ResumeContinuation();
+  }
+}
+
+}// namespace detail
+
+//
+// Starts all tasks concurrently and completes when all of them are finished,
+// results are returned in the order of tasks (nothing for Task<void>).
+// If some of them have failed the first caught exception is rethrown.
+//
+template <typename T>
+Task<detail::WhenAllResult<T>> WhenAll(std::vector<Task<T>> tasks) {
+  struct Awaiter {
+    std::vector<Task<T>>* tasks;
+    const std::shared_ptr<detail::WhenAllState<T>>* state;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) const {
+      (*state)->SetContinuation(awaiting);
+
+      for (size_t i = 0; i < tasks->size(); ++i) {
+        detail::RunWhenAllTask((*tasks)[i], i, *state);
+      }
+
+      return !(*state)->Arrive();
+    }
+
+    detail::WhenAllResult<T> await_resume() const { return (*state)->Result(); }
+  };
+
+  // awaiter intentionally holds only pointers to the frame locals:
+  // it must stay trivially destructible because tasks may finish on other threads
+  const auto state = std::make_shared<detail::WhenAllState<T>>(tasks.size());
+
+  if constexpr (std::is_void_v<T>) {
+    co_await Awaiter{&tasks, &state};
+  } else {
+    co_return co_await Awaiter{&tasks, &state};
+  }
+}
+
+template <typename T>
+std::future<T> StartAsFuture(Task<T> task) {
+  std::promise<T> promise;
+  auto future = promise.get_future();
+
+  [](Task<T> task, std::promise<T> promise) -> detail::DetachedTask {
+    try {
+      if constexpr (std::is_void_v<T>) {
+        co_await std::move(task);
+        promise.set_value();
+      } else {
+        promise.set_value(co_await std::move(task));
+      }
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  }(std::move(task), std::move(promise));
+
+  return future;
+}
+
+//
+// Blocks current thread until the task is finished.
+//
+template <typename T>
+T SyncWait(Task<T> task) {
+  return StartAsFuture(std::move(task)).get();
+}
+
+}// namespace marzbanpp
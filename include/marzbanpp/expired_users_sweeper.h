@@ -0,0 +1,101 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// Deletes expired users in small steps instead of a single DeleteExpiredUsers which may hold
+// the panel database for a long time.
+//
+// The range from the checkpoint to now - grace is split into windows of expiry time. Every window is counted
+// by GetExpiredUsers first: if it holds more than users_per_window users it's shrunk proportionally and counted again,
+// if it's mostly empty the next one is doubled. Non-empty windows are deleted by DeleteExpiredUsers
+// at most once per min_delete_interval. The end of every finished window is saved to the checkpoint file,
+// so an interrupted sweep resumes where it has stopped.
+//
+// GetExpiredUsers returns only users already switched to expired or limited by the periodic review job
+// of the panel, a user whose expire has just passed is still active and isn't counted. Windows end grace before now,
+// so grace must cover the interval of that job: a user missed that way is never seen by later sweeps,
+// the same as a user whose expire is moved before the checkpoint afterwards.
+//
+class ExpiredUsersSweeper final {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using TimePoint = IApi::TimePoint;
+
+  struct Report {
+    uint64_t deleted = 0;
+    size_t windows = 0;// deleted windows
+    size_t requests = 0;// GetExpiredUsers and DeleteExpiredUsers
+    TimePoint swept_until{};
+  };
+
+  struct Options {
+    std::chrono::seconds grace = std::chrono::minutes{5};// users expired less than grace ago are kept
+    uint64_t users_per_window = 500;
+    std::chrono::seconds initial_window = std::chrono::days{1};
+    std::chrono::seconds min_window = std::chrono::minutes{1};
+    std::chrono::seconds max_window = std::chrono::days{365};
+    Clock::duration min_delete_interval = std::chrono::seconds{1};
+
+    // empty path keeps the checkpoint in memory only, unreadable file is treated as missing
+    std::filesystem::path checkpoint;
+    // lower bound of the first sweep when there is no checkpoint yet
+    TimePoint start{};
+
+    Clock::duration interval = std::chrono::hours{1};// between background sweeps
+    std::function<void(const Report& report)> on_sweep;// called by the background thread after every sweep
+  };
+
+  explicit ExpiredUsersSweeper(IApi::Ptr api);
+  ExpiredUsersSweeper(IApi::Ptr api, Options options);
+
+  ExpiredUsersSweeper(const ExpiredUsersSweeper&) = delete;
+  ExpiredUsersSweeper& operator=(const ExpiredUsersSweeper&) = delete;
+
+  ~ExpiredUsersSweeper();
+
+  //
+  // Sweeps up to now - grace in the calling thread. Throws if a request fails,
+  // windows finished before that stay checkpointed.
+  //
+  Report Sweep(std::stop_token stop_token = {});
+
+  //
+  // Starts sweeping every interval in a background thread, the first sweep starts right away.
+  //
+  void Start();
+
+  TimePoint Checkpoint() const;
+
+  //
+  // Error of the last background sweep, if it has failed.
+  //
+  std::exception_ptr LastError() const;
+
+ private:
+  void Run(std::stop_token stop_token);
+  bool WaitUntil(Clock::time_point deadline, std::stop_token stop_token);
+
+  void LoadCheckpoint();
+  void SaveCheckpoint(TimePoint checkpoint);
+
+ private:
+  IApi::Ptr api_;
+  Options options_;
+
+  std::mutex sweep_mutex_;
+  std::atomic<TimePoint> checkpoint_;
+  std::chrono::seconds window_;
+  Clock::time_point next_delete_at_;
+
+  mutable std::mutex error_mutex_;
+  std::exception_ptr last_error_;
+
+  std::mutex wait_mutex_;
+  std::condition_variable_any wait_condition_;
+  std::jthread loop_;
+};
+
+}// namespace marzbanpp
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "marzbanpp/api_error.h"
 #include "marzbanpp/types/admin_token.h"
+#include "marzbanpp/user_patch.h"
 #include "net/http_client.h"
+#include "types/exceptions.h"
 #include "types/admins.h"
 #include "types/hosts.h"
 #include "types/inbounds.h"
@@ -10,6 +13,7 @@
 #include "types/user_list.h"
 #include "types/user_usage.h"
 #include "types/users.h"
+#include "types/users_usage.h"
 
 namespace marzbanpp {
 
@@ -43,6 +47,8 @@ class IApi {
     std::optional<std::string> sort;
   };
 
+  using UserCallback = std::function<void(User&& user)>;
+
   struct ExpiredUsersParams {
     std::optional<TimePoint> before;
     std::optional<TimePoint> after;
@@ -65,17 +71,79 @@ class IApi {
   virtual User AddUser(const User& user) const = 0;
   virtual User GetUser(const std::string& username) const = 0;
   virtual User ModifyUser(const std::string& username, const User& modified_user) const = 0;
+
+  //
+  // ModifyUser sending only the fields in which modified differs from original (see MakeUserPatch),
+  // e.g. for a fetched user with a changed expire. Nothing is sent if nothing has changed, original is returned then.
+  //
+  User ModifyUserFields(const User& original, const User& modified) const;
+
   virtual HttpClient::Response RemoveUser(const std::string& username) const = 0;
   virtual User ResetUserDataUsage(const std::string& username) const = 0;
   virtual User RevokeUserSubscription(const std::string& username) const = 0;
   virtual Users GetUsers(const GetUsersParams& params = {}) const = 0;
+
+  //
+  // Same request as GetUsers, returns unparsed JSON body of the successful response.
+  //
+  virtual std::string GetUsersJson(const GetUsersParams& params = {}) const = 0;
+
+  //
+  // GetUsers parsing only fields declared in TUser, e.g.
+  // struct BillingUser { std::optional<std::string> username; std::optional<uint64_t> used_traffic; };
+  //
+  template <typename TUser>
+  UsersOf<TUser> GetUsersAs(const GetUsersParams& params = {}) const;
+
+  //
+  // Same request as GetUsers, but users are parsed while the response is being received
+  // and passed to the callback one by one instead of being collected in memory.
+  // Returns 'total' reported by the server.
+  //
+  virtual uint64_t StreamUsers(const GetUsersParams& params, const UserCallback& callback) const = 0;
+
   virtual HttpClient::Response ResetUsersDataUsage() const = 0;
   virtual UserUsage GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const = 0;
+
+  //
+  // Usage summed over all users per node. If admins aren't empty, only users owned by them are counted.
+  //
+  virtual UsersUsage GetUsersUsage(
+    const TimePoint& start,
+    const TimePoint& end = {},
+    const std::vector<std::string>& admins = {}) const = 0;
+
   virtual User SetOwner(const std::string& username, const std::string& admin_username) const = 0;
   virtual UserList GetExpiredUsers(const ExpiredUsersParams& params = {}) const = 0;
   virtual UserList DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const = 0;
 
+  //
+  // Non-throwing variants for loops where failures are routine, e.g. 404 for a user missing on the panel.
+  // Failed statuses and unparsable bodies are returned as ApiError, transport errors (CurlError) are still thrown.
+  // Default implementations catch exceptions of the throwing methods, Api and the decorators don't throw at all.
+  //
+  virtual ApiResult<User> TryGetUser(const std::string& username) const;
+  virtual ApiResult<User> TryAddUser(const User& user) const;
+  virtual ApiResult<User> TryModifyUser(const std::string& username, const User& modified_user) const;
+  virtual ApiResult<void> TryRemoveUser(const std::string& username) const;
+
   virtual ~IApi() = default;
 };
 
+template <typename TUser>
+UsersOf<TUser> IApi::GetUsersAs(const GetUsersParams& params) const {
+  HttpClient::Response response;
+  response.status_code = static_cast<int>(RestApiStatusCode::kOk);
+  response.body = GetUsersJson(params);
+
+  UsersOf<TUser> users{};
+  const auto error = glz::read<glz::opts{.error_on_unknown_keys = false}>(users, response.body);
+
+  if (error) {
+    throw FromJsonToObjectError{error, std::move(response)};
+  }
+
+  return users;
+}
+
 }// namespace marzbanpp
@@ -1,11 +1,30 @@
 #pragma once
 
+#include "marzbanpp/admin_token_refresher.h"
 #include "marzbanpp/api.h"
 #include "marzbanpp/api_decorator.h"
+#include "marzbanpp/api_error.h"
+#include "marzbanpp/api_requests.h"
+#include "marzbanpp/async_api.h"
+#include "marzbanpp/bulk_operations.h"
+#include "marzbanpp/co_api.h"
+#include "marzbanpp/coalescing_api.h"
+#include "marzbanpp/coro/scheduler.h"
+#include "marzbanpp/coro/task.h"
+#include "marzbanpp/expired_users_sweeper.h"
 #include "marzbanpp/finally.h"
 #include "marzbanpp/iapi.h"
+#include "marzbanpp/net/async_http_client.h"
 #include "marzbanpp/net/http_client.h"
 #include "marzbanpp/net/http_headers.h"
+#include "marzbanpp/net/http_request.h"
+#include "marzbanpp/net/metrics.h"
+#include "marzbanpp/net/request_limiter.h"
+#include "marzbanpp/net/response_headers.h"
+#include "marzbanpp/panel_snapshot.h"
+#include "marzbanpp/parse_response.h"
+#include "marzbanpp/reconciler.h"
+#include "marzbanpp/retrying_api.h"
 #include "marzbanpp/types/admin.h"
 #include "marzbanpp/types/admin_token.h"
 #include "marzbanpp/types/admins.h"
@@ -17,4 +36,11 @@
 #include "marzbanpp/types/user.h"
 #include "marzbanpp/types/user_list.h"
 #include "marzbanpp/types/user_usage.h"
-#include "marzbanpp/types/users.h"
\ No newline at end of file
+#include "marzbanpp/types/users.h"
+#include "marzbanpp/types/users_usage.h"
+#include "marzbanpp/usage_collector.h"
+#include "marzbanpp/user_mirror.h"
+#include "marzbanpp/user_patch.h"
+#include "marzbanpp/user_range.h"
+#include "marzbanpp/user_table.h"
+#include "marzbanpp/users_stream_parser.h"
\ No newline at end of file
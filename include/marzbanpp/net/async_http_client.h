@@ -0,0 +1,90 @@
+#pragma once
+
+#include "http_client.h"
+#include "http_request.h"
+
+namespace marzbanpp {
+
+//
+// AsyncHttpClient drives all in-flight requests through one curl multi handle
+// on a dedicated event loop thread. Easy handles, DNS cache and TLS sessions
+// are taken from the HttpClient passed to the constructor, connections are kept by the multi handle.
+//
+// Callbacks are invoked on the event loop thread, so they must not block.
+// Exceptions thrown by callbacks are caught and dropped.
+//
+class AsyncHttpClient final {
+ public:
+  using Ptr = std::shared_ptr<AsyncHttpClient>;
+
+  struct Result {
+    CURLcode code;
+    HttpClient::Response response;
+    std::exception_ptr error;// thrown by request.body_sink, the transfer is aborted then
+  };
+
+  using Callback = std::function<void(Result&& result)>;
+
+  AsyncHttpClient();
+  explicit AsyncHttpClient(HttpClient::Ptr http_client);
+
+  //
+  // Stops the event loop. Requests which haven't been completed yet
+  // are finished with CURLE_ABORTED_BY_CALLBACK code.
+  //
+  ~AsyncHttpClient();
+
+  AsyncHttpClient(const AsyncHttpClient&) = delete;
+  AsyncHttpClient& operator=(const AsyncHttpClient&) = delete;
+
+  void Perform(HttpRequest request, Callback callback) const;
+
+  //
+  // Returns number of requests which were passed to Perform and haven't been completed yet.
+  //
+  size_t InFlight() const noexcept;
+
+  //
+  // Returns number of requests which haven't been started yet, e.g. because the limiter doesn't admit them.
+  //
+  size_t Queued() const;
+
+  const HttpClient::Ptr& Transport() const noexcept;
+
+ private:
+  friend class HttpClient;
+
+  //
+  // Used by HttpClient in HTTP/2 mode, the client must outlive the created object.
+  //
+  explicit AsyncHttpClient(const HttpClient& transport);
+
+  void Start();
+
+  struct Transfer {
+    HttpRequest request;
+    Callback callback;
+    HttpClient::Receiver receiver;
+    CURL* easy = nullptr;
+    bool admitted = false;// by the limiter, so it must be released
+    IRequestLimiter::Clock::time_point started;
+  };
+
+  void Run(std::stop_token stop_token);
+  void StartQueuedTransfers();
+  void FinishCompletedTransfers();
+  void Finish(std::unique_ptr<Transfer> transfer, CURLcode code);
+
+ private:
+  HttpClient::Ptr http_client_;
+  const HttpClient* transport_;
+  CURLM* multi_;
+  mutable std::mutex queue_mutex_;
+  mutable std::vector<std::unique_ptr<Transfer>> queue_;
+  mutable std::atomic<size_t> in_flight_;
+  std::unordered_map<CURL*, std::unique_ptr<Transfer>> running_;
+  bool throttled_ = false;
+  std::jthread loop_;
+};
+
+}// namespace marzbanpp
@@ -5,25 +5,74 @@
 #include <string>
 
 #include "http_headers.h"
+#include "http_request.h"
+#include "metrics.h"
+#include "request_limiter.h"
+#include "response_headers.h"
 
 namespace marzbanpp {
 
+class AsyncHttpClient;
+
+//
+// HttpClient keeps a pool of curl easy handles and a curl share object
+// (DNS cache and TLS sessions) for its whole lifetime. Every pooled handle keeps its own connection,
+// so subsequent requests to the same host reuse already established keep-alive connections.
+// It's safe to use one instance from many threads simultaneously.
+//
 class HttpClient final {
  public:
+  using Ptr = std::shared_ptr<HttpClient>;
+
+  enum class HttpVersion {
+    kDefault,// libcurl default: HTTP/2 if the server offers it over TLS, HTTP/1.1 otherwise
+    kHttp11,
+    kHttp2,// HTTP/2 over TLS, HTTP/1.1 for plain http or if the server doesn't support it
+    kHttp2PriorKnowledge,// HTTP/2 without TLS (h2c), the server must support it
+  };
+
   struct BasicAuth {
     std::string username;
     std::string password;
   };
 
   struct Response {
-    using Headers = std::vector<std::string>;
+    using Headers = ResponseHeaders;
 
-    int status_code;
+    int status_code = 0;
     std::string body;
     Headers headers;
+    TransferTimings timings;
+    // set when the client collects metrics, ParseResponse records parse time there
+    EndpointMetrics::Ptr metrics;
+  };
+
+  struct Options {
+    // how many idle easy handles are kept for reuse, handles above this limit are destroyed after use
+    size_t max_idle_handles = 16;
+    // enables TCP keep-alive probes on connections to keep them alive between requests
+    bool tcp_keep_alive = true;
+    // every request waits for the limiter's permission, nullptr disables limiting
+    IRequestLimiter::Ptr limiter;
+    // value of Accept-Encoding header, responses are decompressed transparently;
+    // empty string asks for every encoding libcurl was built with (e.g. "gzip, deflate, br, zstd"),
+    // std::nullopt doesn't send the header
+    std::optional<std::string> accept_encoding;
+    // with kHttp2 and kHttp2PriorKnowledge all requests (Perform, Get, Put, Post, Delete) of all threads are sent
+    // through one curl multi handle, so concurrent requests to a panel are multiplexed over a few connections
+    HttpVersion http_version = HttpVersion::kDefault;
+    // limits connections to one host opened by a multi handle (HTTP/2 mode and AsyncHttpClient), 0 - no limit
+    size_t max_host_connections = 0;
+    // latency, curl phases, bytes and errors are recorded per HttpRequest::endpoint, nullptr disables it
+    Metrics::Ptr metrics;
   };
 
   HttpClient();
+  explicit HttpClient(const Options& options);
+  ~HttpClient();
+
+  HttpClient(const HttpClient&) = delete;
+  HttpClient& operator=(const HttpClient&) = delete;
 
   Response Get(
     const std::string& uri,
@@ -48,6 +97,69 @@ class HttpClient final {
     const std::string& payload,
     const HttpHeaders& headers = {},
     bool follow_location = true) const;
+
+  Response Perform(const HttpRequest& request) const;
+
+  const IRequestLimiter::Ptr& Limiter() const noexcept;
+  const Metrics::Ptr& GetMetrics() const noexcept;
+
+ private:
+  friend class AsyncHttpClient;
+
+  struct Receiver {
+    CURL* easy = nullptr;
+    const BodySink* body_sink = nullptr;
+    Response response;
+    std::exception_ptr error;
+  };
+
+  Response Perform(
+    HttpMethod method,
+    const std::string& uri,
+    const std::string& payload,
+    const HttpHeaders& headers,
+    const std::optional<BasicAuth>& auth,
+    bool follow_location,
+    const BodySink* body_sink,
+    std::string_view endpoint) const;
+
+  static void SetupHandle(
+    CURL* easy,
+    HttpMethod method,
+    const std::string& uri,
+    const std::string& payload,
+    const HttpHeaders& headers,
+    bool follow_location,
+    Receiver& receiver);
+
+  static void ReserveBody(CURL* easy, std::string& body);
+  static size_t WriteBodyCallback(void* buffer, size_t size, size_t nmemb, void* user_data);
+  static size_t WriteHeaderCallback(void* buffer, size_t size, size_t nmemb, void* user_data);
+
+  bool Multiplexed() const noexcept;
+  Response PerformMultiplexed(const HttpRequest& request) const;
+
+  static bool IsOverloaded(CURLcode code, int status_code) noexcept;
+  static void ReadTimings(CURL* easy, TransferTimings& timings) noexcept;
+
+  //
+  // Fills response timings and records the transfer if metrics are enabled.
+  //
+  void RecordTransfer(CURL* easy, std::string_view endpoint, Response& response) const noexcept;
+
+  CURL* AcquireHandle() const;
+  void ReleaseHandle(CURL* easy) const noexcept;
+
+  static void LockShare(CURL* easy, curl_lock_data data, curl_lock_access access, void* user_data);
+  static void UnlockShare(CURL* easy, curl_lock_data data, void* user_data);
+
+ private:
+  Options options_;
+  CURLSH* share_;
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> share_mutexes_;
+  mutable std::mutex idle_handles_mutex_;
+  mutable std::vector<CURL*> idle_handles_;
+  std::unique_ptr<AsyncHttpClient> multiplexer_;
 };
 
 }// namespace marzbanpp
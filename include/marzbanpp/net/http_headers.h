@@ -2,17 +2,21 @@
 
 namespace marzbanpp {
 
+//
+// Copies of HttpHeaders share the same immutable curl list, so prebuilt headers
+// can be attached to any number of requests without rebuilding the list.
+// Add() copies the list first if it's shared with other objects.
+//
 class HttpHeaders final {
  public:
   HttpHeaders();
-  ~HttpHeaders();
 
   void Add(const std::string& name, const std::string& value);
 
   curl_slist* Get() const noexcept;
 
  private:
-  curl_slist* headers_;
+  std::shared_ptr<curl_slist> headers_;
 };
 
 }// namespace marzbanpp
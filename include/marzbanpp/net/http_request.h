@@ -0,0 +1,31 @@
+#pragma once
+
+#include "http_headers.h"
+
+namespace marzbanpp {
+
+enum class HttpMethod {
+  kGet,
+  kPost,
+  kPut,
+  kDelete,
+};
+
+//
+// Receives response body chunks as they arrive instead of accumulating them in Response::body.
+// It's used only for successful (200) responses, bodies of failed responses are accumulated as usual.
+// Exception thrown from the sink aborts the transfer and is rethrown to the caller.
+//
+using BodySink = std::function<void(std::string_view chunk)>;
+
+struct HttpRequest {
+  std::string_view endpoint;// name of the api method for metrics, must be a string literal
+  HttpMethod method = HttpMethod::kGet;
+  std::string uri;
+  std::string payload;// ignored for GET requests
+  HttpHeaders headers;
+  bool follow_location = true;
+  BodySink body_sink;
+};
+
+}// namespace marzbanpp
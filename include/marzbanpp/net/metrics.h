@@ -0,0 +1,147 @@
+#pragma once
+
+namespace marzbanpp {
+
+//
+// Durations of a transfer as curl reports them (each one is measured from the start of the transfer)
+// and the amount of transferred bytes. bytes_sent and bytes_received include headers,
+// body bytes are counted both as received (compressed if the server has compressed them) and after decoding.
+//
+struct TransferTimings {
+  std::chrono::microseconds namelookup{};
+  std::chrono::microseconds connect{};
+  std::chrono::microseconds appconnect{};// TLS handshake is finished, 0 for plain HTTP
+  std::chrono::microseconds starttransfer{};
+  std::chrono::microseconds total{};
+  uint64_t bytes_sent = 0;
+  uint64_t bytes_received = 0;
+  uint64_t body_bytes_received = 0;
+  uint64_t body_bytes_decoded = 0;
+  uint64_t new_connections = 0;// 0 if an existing connection was reused
+};
+
+//
+// HDR-style histogram of durations: every power of two of microseconds is split into kSubBuckets
+// linear buckets, so any value from 1us to days is recorded with at most 1/kSubBuckets relative error.
+// Recording is a few relaxed atomic increments without locks and allocations.
+//
+class LatencyHistogram final {
+ public:
+  static constexpr size_t kSubBuckets = 8;
+  static constexpr size_t kBuckets = kSubBuckets * 40;
+
+  struct Snapshot {
+    std::array<uint64_t, kBuckets> counts{};
+    uint64_t count = 0;
+    std::chrono::microseconds sum{};
+    std::chrono::microseconds max{};
+
+    //
+    // Upper bound of the bucket containing the q-th quantile, q is in [0, 1].
+    //
+    std::chrono::microseconds Percentile(double q) const noexcept;
+
+    //
+    // Number of values not greater than bound, counted by whole buckets.
+    //
+    uint64_t CountNotAbove(std::chrono::microseconds bound) const noexcept;
+  };
+
+  void Record(std::chrono::microseconds value) noexcept;
+
+  Snapshot Take() const noexcept;
+
+  static size_t BucketIndex(uint64_t microseconds) noexcept;
+  static uint64_t BucketUpperBound(size_t index) noexcept;
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+//
+// Metrics of one IApi method (requests are tagged by HttpRequest::endpoint).
+//
+class EndpointMetrics final {
+ public:
+  using Ptr = std::shared_ptr<EndpointMetrics>;
+
+  //
+  // Curl phases as durations: namelookup, connect (TCP), appconnect (TLS),
+  // starttransfer (waiting for the server) and transfer (receiving the response).
+  //
+  static constexpr std::array<std::string_view, 5> kPhases{"namelookup", "connect", "appconnect", "starttransfer", "transfer"};
+
+  struct Snapshot {
+    uint64_t requests = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    uint64_t body_bytes_received = 0;
+    uint64_t body_bytes_decoded = 0;
+    uint64_t new_connections = 0;
+    LatencyHistogram::Snapshot latency;
+    LatencyHistogram::Snapshot parse;
+    std::array<std::chrono::microseconds, kPhases.size()> phases{};// sums over all requests
+    std::map<int, uint64_t> errors;// by status code, transport errors are under 0
+  };
+
+  //
+  // status_code is 0 if the transfer has failed.
+  //
+  void RecordTransfer(int status_code, const TransferTimings& timings) noexcept;
+  void RecordParse(std::chrono::steady_clock::duration duration) noexcept;
+
+  Snapshot Take() const;
+
+ private:
+  std::atomic<uint64_t> requests_{0};
+  std::atomic<uint64_t> bytes_sent_{0};
+  std::atomic<uint64_t> bytes_received_{0};
+  std::atomic<uint64_t> body_bytes_received_{0};
+  std::atomic<uint64_t> body_bytes_decoded_{0};
+  std::atomic<uint64_t> new_connections_{0};
+  LatencyHistogram latency_;
+  LatencyHistogram parse_;
+  std::array<std::atomic<uint64_t>, kPhases.size()> phases_{};
+
+  // errors are rare, so a mutex doesn't slow down successful requests
+  mutable std::mutex errors_mutex_;
+  std::map<int, uint64_t> errors_;
+};
+
+//
+// Registry of per endpoint metrics which is passed to HttpClient through its options.
+// Requests without endpoint are recorded as "other". It's thread-safe.
+//
+class Metrics final {
+ public:
+  using Ptr = std::shared_ptr<Metrics>;
+
+  struct Snapshot {
+    std::map<std::string, EndpointMetrics::Snapshot> endpoints;
+  };
+
+  EndpointMetrics::Ptr Endpoint(std::string_view name);
+
+  Snapshot Take() const;
+
+  //
+  // Prometheus text exposition format. Histogram buckets are reduced to a fixed set of bounds
+  // from 1ms to 30s, which are rounded to the internal bucket boundaries.
+  //
+  std::string Prometheus() const;
+
+ private:
+  struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view value) const noexcept { return std::hash<std::string_view>{}(value); }
+  };
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, EndpointMetrics::Ptr, StringHash, std::equal_to<>> endpoints_;
+};
+
+}// namespace marzbanpp
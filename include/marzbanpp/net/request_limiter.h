@@ -0,0 +1,111 @@
+#pragma once
+
+namespace marzbanpp {
+
+//
+// Paces requests sent by HttpClient and AsyncHttpClient, so the panel isn't overloaded.
+// Every request is admitted by Acquire/TryAcquire and reported by Release when it's finished.
+// Implementations must be thread-safe.
+//
+class IRequestLimiter {
+ public:
+  using Ptr = std::shared_ptr<IRequestLimiter>;
+  using Clock = std::chrono::steady_clock;
+
+  struct Outcome {
+    Clock::duration latency{};
+    bool overloaded = false;// transport error, 429 or 5xx response
+  };
+
+  //
+  // Blocks until the request may be sent.
+  //
+  virtual void Acquire() = 0;
+
+  //
+  // Non-blocking version of Acquire, returns false if the request must wait.
+  //
+  virtual bool TryAcquire() = 0;
+
+  virtual void Release(const Outcome& outcome) noexcept = 0;
+
+  //
+  // Current limit: requests per second for rate limiters, concurrent requests for concurrency limiters.
+  //
+  virtual double Limit() const = 0;
+
+  //
+  // Number of threads blocked in Acquire.
+  //
+  virtual size_t QueueDepth() const = 0;
+
+  virtual ~IRequestLimiter() = default;
+};
+
+//
+// Admits at most 'rate' requests per second on average with bursts up to 'burst' requests.
+//
+class TokenBucketLimiter final : public IRequestLimiter {
+ public:
+  TokenBucketLimiter(double rate, size_t burst);
+
+  void Acquire() override;
+  bool TryAcquire() override;
+  void Release(const Outcome& outcome) noexcept override;
+  double Limit() const override;
+  size_t QueueDepth() const override;
+
+ private:
+  void Refill(Clock::time_point now);
+
+ private:
+  const double rate_;
+  const double burst_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  double tokens_;
+  Clock::time_point refilled_at_;
+  size_t waiting_;
+};
+
+//
+// Adaptive concurrency limit (additive increase, multiplicative decrease).
+// The limit grows by one per limit successful requests and is multiplied by backoff
+// when a request is overloaded or slower than latency_threshold.
+// Decreases are at most once per latency_threshold, so one burst of errors is counted once.
+//
+class AimdLimiter final : public IRequestLimiter {
+ public:
+  struct Options {
+    double initial_limit = 8;
+    double min_limit = 1;
+    double max_limit = 256;
+    double backoff = 0.5;
+    Clock::duration latency_threshold = std::chrono::seconds{2};
+  };
+
+  AimdLimiter();
+  explicit AimdLimiter(const Options& options);
+
+  void Acquire() override;
+  bool TryAcquire() override;
+  void Release(const Outcome& outcome) noexcept override;
+  double Limit() const override;
+  size_t QueueDepth() const override;
+
+ private:
+  bool HasCapacity() const noexcept;
+
+ private:
+  const Options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  double limit_;
+  size_t in_flight_;
+  size_t waiting_;
+  Clock::time_point decreased_at_;
+};
+
+}// namespace marzbanpp
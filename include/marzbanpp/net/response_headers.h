@@ -0,0 +1,94 @@
+#pragma once
+
+namespace marzbanpp {
+
+//
+// Header lines of a response (of all responses if redirects were followed) stored in one buffer
+// exactly as they were received. Lines are split only when they are iterated or searched.
+//
+class ResponseHeaders final {
+ public:
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::string_view;
+    using reference = std::string_view;
+    using pointer = void;
+
+    Iterator() = default;
+    explicit Iterator(std::string_view rest) noexcept : rest_{rest}, line_{NextLine(rest)} {}
+
+    std::string_view operator*() const noexcept { return line_; }
+
+    Iterator& operator++() noexcept {
+      rest_.remove_prefix(line_.size());
+      line_ = NextLine(rest_);
+      return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+      auto copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const Iterator& other) const noexcept { return rest_.data() == other.rest_.data(); }
+
+   private:
+    static std::string_view NextLine(std::string_view rest) noexcept {
+      const auto end = rest.find('\n');
+      return end == std::string_view::npos ? rest : rest.substr(0, end + 1);
+    }
+
+   private:
+    std::string_view rest_;
+    std::string_view line_;
+  };
+
+  void Append(std::string_view line) { raw_.append(line); }
+  void Reserve(size_t size) { raw_.reserve(size); }
+
+  Iterator begin() const noexcept { return Iterator{raw_}; }
+  Iterator end() const noexcept { return Iterator{std::string_view{raw_}.substr(raw_.size())}; }
+
+  bool empty() const noexcept { return raw_.empty(); }
+  size_t size() const noexcept { return static_cast<size_t>(std::distance(begin(), end())); }
+
+  //
+  // Returns trimmed value of the last header with the name (case-insensitive).
+  //
+  std::optional<std::string_view> Find(std::string_view name) const noexcept {
+    std::optional<std::string_view> found;
+
+    for (const auto line : *this) {
+      const auto colon = line.find(':');
+
+      if (colon != name.size() || !EqualIgnoringCase(line.substr(0, colon), name)) {
+        continue;
+      }
+
+      auto value = line.substr(colon + 1);
+      const auto first = value.find_first_not_of(" \t");
+      const auto last = value.find_last_not_of(" \t\r\n");
+
+      found = first == std::string_view::npos ? std::string_view{} : value.substr(first, last - first + 1);
+    }
+
+    return found;
+  }
+
+  const std::string& Raw() const noexcept { return raw_; }
+
+ private:
+  static bool EqualIgnoringCase(std::string_view lhs, std::string_view rhs) noexcept {
+    return std::ranges::equal(lhs, rhs, [](char left, char right) {
+      return std::tolower(static_cast<unsigned char>(left)) == std::tolower(static_cast<unsigned char>(right));
+    });
+  }
+
+ private:
+  std::string raw_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// Panel state which a service needs to start answering requests.
+//
+struct PanelSnapshot {
+  Users users;// ordered by creation time, as UserMirror requests them
+  Hosts hosts;
+  Inbounds inbounds;
+  Admins admins;
+  uint64_t taken_at = 0;// utc timestamp
+};
+
+struct SnapshotFormatError : MarzbanppError {
+  using MarzbanppError::MarzbanppError;
+};
+
+//
+// Requests users, hosts, inbounds and admins from the panel.
+//
+PanelSnapshot TakePanelSnapshot(const IApi& api);
+
+//
+// Snapshot files are a short header followed by glaze BEVE (binary JSON) encoding of PanelSnapshot,
+// which is several times smaller than JSON and is parsed without number and string unescaping.
+// The file is written next to the destination and renamed over it, so readers never see a partial file.
+//
+void SavePanelSnapshot(const PanelSnapshot& snapshot, const std::filesystem::path& path);
+
+//
+// Returns std::nullopt if the file doesn't exist or was written by an incompatible version of the library,
+// throws SnapshotFormatError if it's damaged.
+//
+std::optional<PanelSnapshot> LoadPanelSnapshot(const std::filesystem::path& path);
+
+}// namespace marzbanpp
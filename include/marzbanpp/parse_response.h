@@ -0,0 +1,54 @@
+#pragma once
+
+#include "marzbanpp/api_error.h"
+#include "marzbanpp/iapi.h"
+#include "marzbanpp/types/exceptions.h"
+
+namespace marzbanpp {
+
+//
+// Response is taken by value, so it's moved into the error if the call has failed.
+//
+template <typename T>
+ApiResult<T> TryParseResponse(HttpClient::Response response) {
+  if (response.status_code != static_cast<int>(IApi::RestApiStatusCode::kOk) || response.body.empty()) {
+    return std::unexpected{ApiError::Status(std::move(response))};
+  }
+
+  const auto started = std::chrono::steady_clock::now();
+  auto parsed = glz::read_json<T>(response.body);
+
+  if (response.metrics) {
+    response.metrics->RecordParse(std::chrono::steady_clock::now() - started);
+  }
+
+  if (parsed) {
+    return std::move(*parsed);
+  }
+
+  return std::unexpected{ApiError::Parse(parsed.error(), std::move(response))};
+}
+
+template <typename T>
+T ParseResponse(HttpClient::Response response) {
+  auto result = TryParseResponse<T>(std::move(response));
+
+  if (!result) {
+    std::move(result.error()).Throw();
+  }
+
+  return std::move(*result);
+}
+
+//
+// Used for calls returning raw response which must be successful.
+//
+inline HttpClient::Response CheckResponse(HttpClient::Response response) {
+  if (response.status_code != static_cast<int>(IApi::RestApiStatusCode::kOk)) {
+    throw MarzbanServerResponseError{std::move(response)};
+  }
+
+  return response;
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+struct ReconcileAction {
+  enum class Kind : uint8_t {
+    kAdd,// AddUser, followed by SetOwner if user.admin is set
+    kModify,// ModifyUser with only the changed fields (listed in 'fields') set in user
+    kSetOwner,
+    kRemove,
+  };
+
+  Kind kind;
+  std::string username;
+  User user;
+  std::vector<std::string_view> fields;
+  std::string admin_username;// kSetOwner and kAdd of owned users
+};
+
+struct ReconcilePlan {
+  std::vector<ReconcileAction> actions;
+  size_t desired = 0;
+  size_t live = 0;
+  size_t unchanged = 0;
+  std::chrono::steady_clock::duration elapsed{};// receiving live users and diffing
+
+  //
+  // One line per action, e.g. "~ alice: expire, data_limit", usable as a dry-run output.
+  //
+  std::string Describe() const;
+};
+
+//
+// Brings users on the panel to a desired state kept elsewhere.
+//
+// Desired users are compared with the live ones field by field. Unset (std::nullopt) fields are "don't care":
+// they are neither compared nor sent. Read-only fields (traffic, links, timestamps of activity) are ignored,
+// inbounds are compared as sets. Only the fields which differ are sent by ModifyUser (see MakeUserPatch):
+// a differing nested object such as proxies is completed from the live user, because the panel replaces it whole.
+// The owner is changed by SetOwner if admin.username is set.
+// Panel users missing in the desired state are removed only if options.remove_missing is set.
+//
+// Plan only reads the panel, so it's a dry run; Apply sends the planned calls by options.parallelism threads,
+// actions of the same user are sent one after another in the plan order.
+//
+class Reconciler final {
+ public:
+  //
+  // Streamed desired state: the source passes every desired user to the callback.
+  //
+  using UserSource = std::function<void(const IApi::UserCallback& callback)>;
+
+  struct Options {
+    size_t parallelism = 8;
+    bool remove_missing = false;
+  };
+
+  struct Report {
+    size_t added = 0;
+    size_t modified = 0;
+    size_t owners_set = 0;
+    size_t removed = 0;
+    size_t requests = 0;
+    std::vector<std::pair<size_t, std::exception_ptr>> failed;// index of the action in the plan
+    std::chrono::steady_clock::duration elapsed{};
+
+    double ActionsPerSecond() const noexcept;
+  };
+
+  explicit Reconciler(IApi::Ptr api);
+  Reconciler(IApi::Ptr api, Options options);
+
+  //
+  // Throws if a desired user has no username or the same username is met twice.
+  //
+  ReconcilePlan Plan(std::span<const User> desired) const;
+  ReconcilePlan Plan(const UserSource& desired) const;
+
+  Report Apply(const ReconcilePlan& plan) const;
+
+  Report Reconcile(std::span<const User> desired) const;
+
+ private:
+  IApi::Ptr api_;
+  Options options_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// Decorator which retries idempotent reads (GetUser, TryGetUser, GetUsers, GetUsersJson, GetSystemStats, GetHosts,
+// GetInbounds, GetUserUsage, GetUsersUsage) failed with CurlError, 429 or 5xx, waiting a jittered exponential backoff
+// between attempts. Other methods are forwarded to the wrapped api as is.
+//
+// With hedging enabled the same reads are additionally duplicated: if the first request isn't answered
+// within the configured percentile of recent latencies, the second one is sent and the first successful
+// response wins; the call fails only if both requests have failed. Both requests are sent by background threads
+// (two per hedged call), at most max_hedged_calls calls are hedged at once, the others are sent by the calling
+// thread without hedging. The losing request isn't cancelled, it finishes in background; the destructor waits for it.
+//
+class RetryingApi : public IApi {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    size_t max_attempts = 3;
+    Clock::duration initial_backoff = std::chrono::milliseconds{100};
+    Clock::duration max_backoff = std::chrono::seconds{2};
+    double backoff_multiplier = 2;
+
+    bool hedging = false;
+    double hedging_percentile = 0.95;
+    Clock::duration min_hedging_delay = std::chrono::milliseconds{5};
+    size_t max_hedged_calls = 4;
+    size_t latency_samples = 256;// window of recent latencies the percentile is taken from
+  };
+
+  explicit RetryingApi(IApi::Ptr api);
+  RetryingApi(IApi::Ptr api, Options options);
+  ~RetryingApi() override;
+
+  void SetAdminToken(const AdminToken& token) override;
+
+  Admin GetCurrentAdmin() const override;
+  Admin CreateAdmin(const Admin& admin) const override;
+  Admin ModifyAdmin(const std::string& username, const Admin& admin) const override;
+  Admin RemoveAdmin(const std::string& username) const override;
+  Admins GetAdmins(const GetAdminsParams& params = {}) const override;
+
+  System GetSystemStats() const override;
+  Inbounds GetInbounds() const override;
+  Hosts GetHosts() const override;
+  Hosts ModifyHosts(const Hosts& hosts) const override;
+
+  User AddUser(const User& user) const override;
+  User GetUser(const std::string& username) const override;
+  User ModifyUser(const std::string& username, const User& modified_user) const override;
+  HttpClient::Response RemoveUser(const std::string& username) const override;
+  User ResetUserDataUsage(const std::string& username) const override;
+  User RevokeUserSubscription(const std::string& username) const override;
+  Users GetUsers(const GetUsersParams& params = {}) const override;
+  std::string GetUsersJson(const GetUsersParams& params = {}) const override;
+  uint64_t StreamUsers(const GetUsersParams& params, const UserCallback& callback) const override;
+  HttpClient::Response ResetUsersDataUsage() const override;
+  UserUsage GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end = {}) const override;
+  UsersUsage GetUsersUsage(
+    const TimePoint& start,
+    const TimePoint& end = {},
+    const std::vector<std::string>& admins = {}) const override;
+  User SetOwner(const std::string& username, const std::string& admin_username) const override;
+  UserList GetExpiredUsers(const ExpiredUsersParams& params = {}) const override;
+  UserList DeleteExpiredUsers(const ExpiredUsersParams& params = {}) const override;
+
+  ApiResult<User> TryGetUser(const std::string& username) const override;
+  ApiResult<User> TryAddUser(const User& user) const override;
+  ApiResult<User> TryModifyUser(const std::string& username, const User& modified_user) const override;
+  ApiResult<void> TryRemoveUser(const std::string& username) const override;
+
+  //
+  // Delay after which a hedged request is sent, empty while there are too few latency samples.
+  //
+  std::optional<Clock::duration> HedgingDelay() const;
+
+ private:
+  class HedgeExecutor;
+
+  template <typename T>
+  T Idempotent(std::function<T(const IApi&)> call) const;
+
+  template <typename T>
+  T Hedged(const std::function<T(const IApi&)>& call, Clock::duration delay) const;
+
+  Clock::duration Backoff(size_t attempt) const;
+  void RecordLatency(Clock::duration latency) const;
+
+ private:
+  IApi::Ptr api_;
+  Options options_;
+
+  mutable std::mutex latencies_mutex_;
+  mutable std::vector<Clock::duration> latencies_;
+  mutable size_t next_latency_;
+
+  mutable std::atomic<size_t> hedged_calls_;
+  std::unique_ptr<HedgeExecutor> hedges_;
+};
+
+}// namespace marzbanpp
@@ -1,19 +1,40 @@
 #pragma once
 
 // C/C++
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <charconv>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <coroutine>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <expected>
 #include <filesystem>
+#include <fstream>
 #include <functional>
 #include <future>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <random>
+#include <shared_mutex>
+#include <span>
 #include <stop_token>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 #include <vector>
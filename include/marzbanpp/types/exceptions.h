@@ -23,15 +23,21 @@ class FromJsonToObjectError : public MarzbanppError {
  public:
   FromJsonToObjectError(
     const glz::error_ctx& error_ctx,
-    const HttpClient::Response& response)
+    HttpClient::Response response)
       : MarzbanppError{glz::format_error(error_ctx, response.body)},
-        response_{response} {}
+        error_ctx_{error_ctx},
+        response_{std::move(response)} {}
+
+  const glz::error_ctx& ErrorContext() const noexcept {
+    return error_ctx_;
+  }
 
   const HttpClient::Response& Response() const noexcept {
     return response_;
   }
 
  private:
+  glz::error_ctx error_ctx_;
   HttpClient::Response response_;
 };
 
@@ -44,6 +50,10 @@ class ToObjectFromJsonError : public MarzbanppError {
   std::string error_explanation_;
 };
 
+struct MalformedUsersStreamError : MarzbanppError {
+  using MarzbanppError::MarzbanppError;
+};
+
 struct UsernameFieldInUserWasNotSet : MarzbanppError {
   using MarzbanppError::MarzbanppError;
 };
@@ -74,23 +84,24 @@ class UnexpectedStatusFieldValueInUser : public MarzbanppError {
 
 class MarzbanServerResponseError : public MarzbanppError {
  public:
-  MarzbanServerResponseError(const HttpClient::Response& response)
+  MarzbanServerResponseError(HttpClient::Response response)
       : MarzbanppError{FormatResponse(response)},
-        response_{response} {}
+        response_{std::move(response)} {}
 
   const HttpClient::Response& Response() const noexcept {
     return response_;
   }
 
- private:
-  std::string FormatResponse(const marzbanpp::HttpClient::Response& response) {
+  static std::string FormatResponse(const marzbanpp::HttpClient::Response& response) {
+    const auto& headers = response.headers.Raw();
     auto formatted = std::to_string(response.status_code) + '\n';
 
-    for (const auto& header : response.headers) {
-      formatted += header;
-    }
+    formatted.reserve(formatted.size() + headers.size() + response.body.size() + 3);
+    formatted += headers;
+    formatted += '\n';
+    formatted += response.body;
+    formatted += "\n\n";
 
-    formatted += '\n' + response.body + "\n\n";
     return formatted;
   }
 
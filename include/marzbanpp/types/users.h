@@ -9,4 +9,14 @@ struct Users {
   uint64_t total;
 };
 
+//
+// GetUsers response parsed into a projection: a struct declaring only the User fields
+// the caller needs (with the same names). Other fields are skipped by the parser without being stored.
+//
+template <typename TUser>
+struct UsersOf {
+  std::vector<TUser> users;
+  uint64_t total;
+};
+
 }// namespace marzbanpp
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "user_usage.h"
+
+namespace marzbanpp {
+
+//
+// Traffic of all users (or of users owned by the given admins) summed per node.
+//
+struct UsersUsage {
+  std::vector<UserUsage::Usage> usages;
+};
+
+}// namespace marzbanpp
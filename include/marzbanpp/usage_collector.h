@@ -0,0 +1,57 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// Collects traffic used in a time range and sums it per user, per node and per admin.
+//
+// Per user totals need GetUserUsage for every user: the calls are sent by options.parallelism threads
+// and ranges longer than options.chunk are split, so a single request never has to scan a huge range.
+// When only node and admin totals are needed, the aggregate GetUsersUsage endpoint is used instead
+// (one request per admin). Panels without it are detected by 404/405 and served by the per user path.
+//
+class UsageCollector final {
+ public:
+  using TimePoint = IApi::TimePoint;
+
+  struct Options {
+    size_t parallelism = 8;
+    std::chrono::seconds chunk = std::chrono::days{7};
+    bool per_user = true;
+  };
+
+  struct Report {
+    std::unordered_map<std::string, uint64_t> per_user;
+    std::unordered_map<std::string, uint64_t> per_node;// by node_name
+    std::unordered_map<std::string, uint64_t> per_admin;// users without owner are under ""
+    uint64_t total = 0;
+
+    size_t requests = 0;
+    bool aggregated = false;// true if the aggregate endpoint was used
+
+    // users whose usage (or a part of it) couldn't be received, they are missing in the totals;
+    // for aggregated reports these are admins missing in per_admin, then per_admin[""] is left out too
+    std::vector<std::pair<std::string, std::exception_ptr>> failed;
+  };
+
+  explicit UsageCollector(IApi::Ptr api);
+  UsageCollector(IApi::Ptr api, Options options);
+
+  //
+  // end = {} means now.
+  //
+  Report Collect(const TimePoint& start, const TimePoint& end = {}) const;
+
+ private:
+  std::optional<Report> CollectAggregated(const TimePoint& start, const TimePoint& end) const;
+  Report CollectPerUser(const TimePoint& start, const TimePoint& end) const;
+
+ private:
+  IApi::Ptr api_;
+  Options options_;
+  mutable std::atomic<bool> aggregate_unavailable_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// In-memory copy of all users which is kept up to date by a background thread.
+//
+// Every refresh starts with GetSystemStats: if user counters haven't changed, nothing else is requested.
+// If only new users have appeared, only the pages after the last complete one are requested
+// (users are ordered by creation time), the previous pages are shared with the new snapshot.
+// Counters can't tell it from removing and adding users, so the last kept user is requested first
+// to check that nobody before it has been removed.
+// Otherwise all pages are requested again. A full resync is done every full_resync_interval anyway,
+// because some changes (e.g. traffic or a modified note) aren't visible in the counters,
+// so such changes are up to full_resync_interval old.
+//
+// Readers get immutable snapshots without locking. Read methods taking max_staleness
+// reload all users in the calling thread if the last full sync is older than that.
+//
+class UserMirror final {
+ public:
+  using Ptr = std::shared_ptr<UserMirror>;
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    Clock::duration refresh_interval = std::chrono::seconds{5};
+    Clock::duration full_resync_interval = std::chrono::minutes{5};
+    uint64_t page_size = 500;
+  };
+
+  //
+  // Cheap change signal taken from System. Traffic counters aren't part of it:
+  // they change all the time on a live panel and would turn every refresh into a full one.
+  //
+  struct Signal {
+    uint64_t total_user = 0;
+    uint64_t users_active = 0;
+    uint64_t users_on_hold = 0;
+    uint64_t users_disabled = 0;
+    uint64_t users_expired = 0;
+    uint64_t users_limited = 0;
+
+    bool operator==(const Signal&) const = default;
+  };
+
+  struct Page {
+    std::vector<User> users;
+  };
+
+  struct Snapshot {
+    using Ptr = std::shared_ptr<const Snapshot>;
+
+    std::vector<std::shared_ptr<const Page>> pages;
+    std::unordered_map<std::string_view, const User*> by_username;
+    Signal signal;
+    Clock::time_point full_synced_at;
+
+    const User* Find(std::string_view username) const;
+    size_t Size() const noexcept { return by_username.size(); }
+  };
+
+  //
+  // Loads all users, throws if it fails.
+  //
+  explicit UserMirror(IApi::Ptr api);
+  UserMirror(IApi::Ptr api, Options options);
+
+  //
+  // Starts serving given users (e.g. from a PanelSnapshot) without requesting anything,
+  // the first refresh is done by the background thread right away.
+  // Until it has succeeded Staleness() is unbounded, so read methods taking max_staleness refresh synchronously.
+  //
+  UserMirror(IApi::Ptr api, Options options, std::vector<User> users);
+
+  UserMirror(const UserMirror&) = delete;
+  UserMirror& operator=(const UserMirror&) = delete;
+
+  ~UserMirror();
+
+  Snapshot::Ptr Current() const;
+  Snapshot::Ptr Current(Clock::duration max_staleness);
+
+  std::optional<User> GetUser(const std::string& username, Clock::duration max_staleness);
+
+  //
+  // Time passed since the last successful full sync. Changes which don't move the counters
+  // (expire, note, proxies, traffic) may be missing in the mirror for that long,
+  // so read methods taking max_staleness do a full sync if it's exceeded.
+  //
+  Clock::duration Staleness() const noexcept;
+
+  //
+  // Error of the last background refresh, if it has failed.
+  //
+  std::exception_ptr LastError() const;
+
+  //
+  // Reloads all users in the calling thread.
+  //
+  void Refresh();
+
+ private:
+  void Run(std::stop_token stop_token, Clock::duration first_delay);
+  void Synchronize(bool full);
+
+  //
+  // True if the last user of the first pages of the snapshot is still at the same offset on the panel.
+  //
+  bool PagesInPlace(const Snapshot& snapshot, size_t pages) const;
+
+  std::vector<std::shared_ptr<const Page>> FetchPages(
+    const Snapshot* previous,
+    size_t first_page) const;
+
+ private:
+  IApi::Ptr api_;
+  Options options_;
+
+  std::atomic<std::shared_ptr<const Snapshot>> snapshot_;
+  std::atomic<Clock::rep> synced_at_;// of the last full sync
+
+  std::mutex refresh_mutex_;
+  mutable std::mutex error_mutex_;
+  std::exception_ptr last_error_;
+
+  std::mutex wait_mutex_;
+  std::condition_variable_any wait_condition_;
+  std::jthread loop_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "marzbanpp/types/user.h"
+
+namespace marzbanpp {
+
+//
+// Writable fields of a user which have to be sent to turn one state of the user into another.
+//
+struct UserPatch {
+  User user;// username and the changed fields only
+  std::vector<std::string_view> fields;// names of the changed fields
+
+  bool Empty() const noexcept { return fields.empty(); }
+};
+
+//
+// Compares writable fields of modified with original. Fields unset in modified (at any nesting level)
+// are left as they are, inbounds are compared as sets and an empty list of a protocol counts as unset. Read-only fields (traffic, links, activity) are ignored.
+// A changed nested object is sent whole with its fields unset in modified taken from original,
+// because the panel replaces it on modify: changing the vless flow keeps the vless id and shadowsocks.
+// E.g. a fetched user with a new expire gives {"username":"alice","expire":1735689600}
+// instead of the whole user with its links, proxies and inbounds.
+//
+UserPatch MakeUserPatch(const User& original, const User& modified);
+
+}// namespace marzbanpp
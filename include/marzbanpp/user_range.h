@@ -0,0 +1,98 @@
+#pragma once
+
+#include "marzbanpp/iapi.h"
+
+namespace marzbanpp {
+
+//
+// Single pass range over users returned by GetUsers which requests them page by page.
+// While the caller consumes the current page up to prefetch_depth next pages are being fetched concurrently.
+// So at most prefetch_depth + 1 pages are kept in memory.
+//
+// params.offset is used as the first offset and params.limit as the maximum amount of users to iterate.
+// Pages are planned using 'total' from the first response.
+// Pass a stable 'sort' in params if users can be added or removed during iteration.
+//
+class UserRange final {
+ public:
+  using FetchPage = std::function<std::future<Users>(const IApi::GetUsersParams& params)>;
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = User;
+    using reference = User&;
+    using pointer = User*;
+
+    Iterator() = default;
+    explicit Iterator(UserRange* range) noexcept : range_{range} {}
+
+    User& operator*() const { return range_->Current(); }
+    User* operator->() const { return &range_->Current(); }
+
+    Iterator& operator++() {
+      range_->Advance();
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const Iterator& it, std::default_sentinel_t) { return it.Finished(); }
+
+   private:
+    bool Finished() const noexcept { return !range_ || range_->Done(); }
+
+   private:
+    UserRange* range_ = nullptr;
+  };
+
+  UserRange(FetchPage fetch_page, IApi::GetUsersParams params, uint64_t page_size, size_t prefetch_depth);
+
+  UserRange(UserRange&&) = default;
+  UserRange& operator=(UserRange&&) = default;
+
+  Iterator begin();
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+  //
+  // Returns 'total' reported by the server, it's known after the first page has been received.
+  //
+  std::optional<uint64_t> Total() const noexcept;
+
+ private:
+  User& Current();
+  void Advance();
+  bool Done() const noexcept;
+
+  void SchedulePage(uint64_t size);
+  void SchedulePages();
+  void TakeNextPage();
+
+ private:
+  FetchPage fetch_page_;
+  IApi::GetUsersParams params_;
+  uint64_t page_size_;
+  size_t prefetch_depth_;
+
+  uint64_t next_offset_;
+  std::optional<uint64_t> end_offset_;
+  std::optional<uint64_t> total_;
+  std::deque<std::pair<std::future<Users>, uint64_t>> pending_;
+
+  std::vector<User> page_;
+  size_t index_;
+  bool started_;
+  bool exhausted_;
+};
+
+//
+// Iterates users of the blocking api, pages are prefetched by std::async.
+//
+UserRange IterateUsers(
+  const IApi::Ptr& api,
+  const IApi::GetUsersParams& params = {},
+  uint64_t page_size = 500,
+  size_t prefetch_depth = 2);
+
+}// namespace marzbanpp
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "marzbanpp/types/users.h"
+
+namespace marzbanpp {
+
+enum class UserStatus : uint8_t {
+  kUnknown,
+  kActive,
+  kOnHold,
+  kDisabled,
+  kLimited,
+  kExpired,
+};
+
+UserStatus ParseUserStatus(std::string_view status) noexcept;
+
+//
+// Column-oriented copy of hot User fields for fast scans over many users.
+// Numeric fields are kept in contiguous vectors (missing values are stored as 0),
+// usernames are packed into one buffer and admin usernames are interned.
+//
+// Filters return a Mask with one byte per row (1 if the row matches). They are written
+// as branchless loops over columns, so compilers vectorize them. Masks are combined
+// with And/Or and consumed by Count/Sum/Rows.
+//
+class UserTable final {
+ public:
+  using Mask = std::vector<uint8_t>;
+  using AdminId = uint32_t;
+
+  static constexpr AdminId kNoAdmin = 0;
+
+  UserTable() = default;
+  explicit UserTable(const std::vector<User>& users);
+  explicit UserTable(const Users& users);
+
+  void Reserve(size_t rows);
+
+  //
+  // Appends one row, so the table can be filled from IApi::StreamUsers without keeping Users in memory.
+  //
+  void Append(const User& user);
+
+  size_t Size() const noexcept { return status_.size(); }
+
+  std::span<const uint64_t> Expire() const noexcept { return expire_; }
+  std::span<const uint64_t> DataLimit() const noexcept { return data_limit_; }
+  std::span<const uint64_t> UsedTraffic() const noexcept { return used_traffic_; }
+  std::span<const uint64_t> LifetimeUsedTraffic() const noexcept { return lifetime_used_traffic_; }
+  std::span<const UserStatus> Status() const noexcept { return status_; }
+  std::span<const AdminId> Admin() const noexcept { return admin_; }
+
+  std::string_view Username(size_t row) const noexcept;
+
+  //
+  // Returns kNoAdmin if there is no user owned by the admin.
+  //
+  AdminId FindAdmin(std::string_view username) const noexcept;
+  std::string_view AdminUsername(AdminId admin) const noexcept;
+
+  Mask StatusIs(UserStatus status) const;
+  Mask OwnedBy(std::string_view admin_username) const;
+
+  //
+  // Users with data_limit set and used_traffic >= percent% of data_limit.
+  //
+  Mask TrafficUsedAtLeast(uint32_t percent) const;
+
+  //
+  // Users with expire set and from <= expire < to (utc timestamps).
+  //
+  Mask ExpiresBetween(uint64_t from, uint64_t to) const;
+
+  template <typename T, typename Predicate>
+  static Mask Where(std::span<const T> column, const Predicate& predicate) {
+    Mask mask(column.size());
+
+    for (size_t i = 0; i < column.size(); ++i) {
+      mask[i] = static_cast<uint8_t>(predicate(column[i]));
+    }
+
+    return mask;
+  }
+
+  static void And(Mask& mask, const Mask& other) noexcept;
+  static void Or(Mask& mask, const Mask& other) noexcept;
+
+  static size_t Count(const Mask& mask) noexcept;
+  static uint64_t Sum(std::span<const uint64_t> column, const Mask& mask) noexcept;
+  static std::vector<uint32_t> Rows(const Mask& mask);
+
+ private:
+  std::vector<uint64_t> expire_;
+  std::vector<uint64_t> data_limit_;
+  std::vector<uint64_t> used_traffic_;
+  std::vector<uint64_t> lifetime_used_traffic_;
+  std::vector<UserStatus> status_;
+  std::vector<AdminId> admin_;
+
+  std::string usernames_;
+  std::vector<uint32_t> username_ends_;
+
+  std::vector<std::string> admins_;// admins_[id - 1]
+  std::unordered_map<std::string, AdminId> admin_ids_;
+};
+
+}// namespace marzbanpp
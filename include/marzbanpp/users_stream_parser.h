@@ -0,0 +1,73 @@
+#pragma once
+
+#include "marzbanpp/types/user.h"
+
+namespace marzbanpp {
+
+//
+// Incremental parser of GetUsers response body: {"users": [{...}, ...], "total": N}.
+// Body may be fed by arbitrary chunks, every user is deserialized as soon as its object
+// is complete and passed to the callback, so only one user record is kept in memory.
+//
+class UsersStreamParser final {
+ public:
+  using UserCallback = std::function<void(User&& user)>;
+
+  explicit UsersStreamParser(UserCallback callback);
+
+  void Feed(std::string_view chunk);
+
+  //
+  // Must be called after the whole body has been fed.
+  // Returns 'total' reported by the server, throws MalformedUsersStreamError if the body is incomplete.
+  //
+  uint64_t Finish() const;
+
+  //
+  // Returns number of users passed to the callback.
+  //
+  uint64_t Parsed() const noexcept;
+
+ private:
+  enum class Field {
+    kOther,
+    kUsers,
+    kTotal,
+  };
+
+  enum class Capture {
+    kNone,
+    kUser,
+    kTotal,
+  };
+
+  size_t SkipString(std::string_view chunk, size_t position);
+
+  void BeginCapture(Capture capture, size_t position);
+  void EndCapture(std::string_view chunk, size_t position);
+
+  void OnUser();
+  void OnTotal();
+
+ private:
+  UserCallback callback_;
+
+  size_t depth_;
+  bool in_string_;
+  bool escape_;
+  bool expecting_key_;
+  bool collecting_key_;
+  bool in_users_array_;
+  bool done_;
+  Field field_;
+  std::string key_;
+
+  Capture capture_;
+  size_t capture_begin_;
+  std::string record_;
+
+  std::optional<uint64_t> total_;
+  uint64_t parsed_;
+};
+
+}// namespace marzbanpp
@@ -0,0 +1,148 @@
+#include "marzbanpp/admin_token_refresher.h"
+
+#include "marzbanpp/api.h"
+
+namespace {
+
+struct JwtClaims {
+  std::optional<int64_t> exp;
+};
+
+std::optional<std::string> DecodeBase64Url(std::string_view encoded) {
+  std::string decoded;
+  decoded.reserve(encoded.size() * 3 / 4);
+
+  uint32_t buffer = 0;
+  int bits = 0;
+
+  for (const char symbol : encoded) {
+    uint32_t value = 0;
+
+    if (symbol >= 'A' && symbol <= 'Z') {
+      value = symbol - 'A';
+    } else if (symbol >= 'a' && symbol <= 'z') {
+      value = symbol - 'a' + 26;
+    } else if (symbol >= '0' && symbol <= '9') {
+      value = symbol - '0' + 52;
+    } else if (symbol == '-' || symbol == '+') {
+      value = 62;
+    } else if (symbol == '_' || symbol == '/') {
+      value = 63;
+    } else if (symbol == '=') {
+      break;
+    } else {
+      return std::nullopt;
+    }
+
+    buffer = (buffer << 6) | value;
+    bits += 6;
+
+    if (bits >= 8) {
+      bits -= 8;
+      decoded.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+    }
+  }
+
+  return decoded;
+}
+
+//
+// Returns 'exp' claim of JWT, the signature isn't verified: it's only used to schedule the refresh.
+//
+int64_t ExpirationTime(const std::string& access_token) {
+  const auto first_dot = access_token.find('.');
+  const auto second_dot = access_token.find('.', first_dot + 1);
+
+  if (first_dot == std::string::npos || second_dot == std::string::npos) {
+    return 0;
+  }
+
+  const auto payload = DecodeBase64Url(
+    std::string_view{access_token}.substr(first_dot + 1, second_dot - first_dot - 1));
+
+  if (!payload) {
+    return 0;
+  }
+
+  JwtClaims claims;
+
+  if (glz::read<glz::opts{.error_on_unknown_keys = false}>(claims, *payload)) {
+    return 0;
+  }
+
+  return claims.exp.value_or(0);
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+AdminTokenRefresher::AdminTokenRefresher(
+  std::string uri,
+  std::string username,
+  std::string password,
+  HttpClient::Ptr http_client,
+  Options options)
+    : uri_{std::move(uri)},
+      username_{std::move(username)},
+      password_{std::move(password)},
+      http_client_{std::move(http_client)},
+      options_{options},
+      generation_{0},
+      expires_at_{0} {}
+
+AdminToken AdminTokenRefresher::Login() const {
+  auto token = Api::GetAdminToken(*http_client_, uri_, username_, password_);
+  expires_at_.store(ExpirationTime(token.access_token), std::memory_order_relaxed);
+
+  return token;
+}
+
+uint64_t AdminTokenRefresher::Generation() const noexcept {
+  return generation_.load(std::memory_order_acquire);
+}
+
+void AdminTokenRefresher::Refresh(IApi& api, uint64_t observed_generation) const {
+  std::lock_guard _{refresh_mutex_};
+
+  // the token has been refreshed while the caller was waiting, it's only needed to retry
+  if (generation_.load(std::memory_order_relaxed) != observed_generation) {
+    return;
+  }
+
+  SetToken(api);
+}
+
+void AdminTokenRefresher::RefreshIfExpiring(IApi& api) const {
+  if (!options_.proactive || !Expiring()) {
+    return;
+  }
+
+  std::lock_guard _{refresh_mutex_};
+
+  if (Expiring()) {
+    SetToken(api);
+  }
+}
+
+const HttpClient::Ptr& AdminTokenRefresher::Client() const noexcept {
+  return http_client_;
+}
+
+bool AdminTokenRefresher::Expiring() const noexcept {
+  const auto expires_at = expires_at_.load(std::memory_order_relaxed);
+
+  if (expires_at == 0) {
+    return false;
+  }
+
+  const auto now = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::seconds>(now) + options_.margin >= std::chrono::seconds{expires_at};
+}
+
+void AdminTokenRefresher::SetToken(IApi& api) const {
+  api.SetAdminToken(Login());
+  generation_.fetch_add(1, std::memory_order_release);
+}
+
+}// namespace marzbanpp
@@ -1,9 +1,10 @@
 #include "marzbanpp/api.h"
 
 #include "marzbanpp/net/http_client.h"
-#include "marzbanpp/net/http_headers.h"
+#include "marzbanpp/parse_response.h"
 #include "marzbanpp/types/exceptions.h"
 #include "marzbanpp/types/user.h"
+#include "marzbanpp/users_stream_parser.h"
 
 namespace {
 
@@ -20,21 +21,6 @@ using namespace marzbanpp;
   }
 };
 
-template <typename T>
-T ParseResponse(const HttpClient::Response& response) {
-  if (response.status_code != static_cast<int>(Api::RestApiStatusCode::kOk) || response.body.empty()) {
-    throw MarzbanServerResponseError{response};
-  }
-
-  const auto parsed = glz::read_json<T>(response.body);
-
-  if (parsed) {
-    return *parsed;
-  }
-
-  throw FromJsonToObjectError{parsed.error(), response};
-}
-
 }// namespace
 
 namespace marzbanpp {
@@ -43,436 +29,197 @@ AdminToken Api::GetAdminToken(
   const std::string& uri,
   const std::string& username,
   const std::string& password) {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/x-www-form-urlencoded");
-
-  const auto post_data = fmt::format("username={}&password={}", username, password);
-
   HttpClient http_client;
-  const auto response = http_client.Post(uri + "/api/admin/token", post_data, headers);
+  return GetAdminToken(http_client, uri, username, password);
+}
 
-  auto admin_token = ParseResponse<AdminToken>(response);
-  return admin_token;
+AdminToken Api::GetAdminToken(
+  const HttpClient& http_client,
+  const std::string& uri,
+  const std::string& username,
+  const std::string& password) {
+  return ParseResponse<AdminToken>(http_client.Perform(ApiRequests::GetAdminToken(uri, username, password)));
 }
 
 Api::Ptr
 Api::AuthAndCreate(const std::string& uri, const std::string& username, const std::string& password) {
-  auto admin_token = GetAdminToken(uri, username, password);
+  return AuthAndCreate(uri, username, password, std::make_shared<HttpClient>());
+}
+
+Api::Ptr
+Api::AuthAndCreate(
+  const std::string& uri,
+  const std::string& username,
+  const std::string& password,
+  HttpClient::Ptr http_client) {
+  auto admin_token = GetAdminToken(*http_client, uri, username, password);
+  return Create(uri, admin_token, std::move(http_client));
+}
 
+Api::Ptr
+Api::Create(std::string uri, const AdminToken& token, HttpClient::Ptr http_client) {
   struct MakeSharedEnabler : Api {
-    MakeSharedEnabler(std::string uri, AdminToken token)
+    MakeSharedEnabler(std::string uri, const AdminToken& token, HttpClient::Ptr http_client)
         : Api(
             std::move(uri),
-            std::move(token.token_type),
-            std::move(token.access_token)) {}
+            token.token_type,
+            token.access_token,
+            std::move(http_client)) {}
   };
 
-  return std::make_shared<MakeSharedEnabler>(uri, std::move(admin_token));
+  return std::make_shared<MakeSharedEnabler>(std::move(uri), token, std::move(http_client));
 }
 
 void
 Api::SetAdminToken(const AdminToken& token) {
-  token_type_ = token.token_type;
-  access_token_ = token.access_token;
+  requests_.SetAdminToken(token);
 }
 
 Admin Api::GetCurrentAdmin() const {
-  HttpHeaders headers;
-  HttpClient http_client;
-
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-  const auto response = http_client.Get(uri_ + "/api/admin"s, headers);
-
-  return ParseResponse<Admin>(response);
+  return ParseResponse<Admin>(http_client_->Perform(requests_.GetCurrentAdmin()));
 }
 
 Admin Api::CreateAdmin(const Admin& admin) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/json");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string create_admin_request;
-  const auto error_ctx = glz::write_json(admin, create_admin_request);
-
-  if (error_ctx) {
-    throw ToObjectFromJsonError{error_ctx};
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Post(uri_ + "/api/admin"s, create_admin_request, headers);
-
-  return ParseResponse<Admin>(response);
+  return ParseResponse<Admin>(http_client_->Perform(requests_.CreateAdmin(admin)));
 }
 
 Admin Api::ModifyAdmin(const std::string& username, const Admin& admin) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/json");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string modify_admin_request;
-
-  const auto error_ctx = glz::write_json(admin, modify_admin_request);
-
-  if (error_ctx) {
-    throw ToObjectFromJsonError{error_ctx};
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Put(uri_ + "/api/admin/"s + username, modify_admin_request, headers);
-
-  return ParseResponse<Admin>(response);
+  return ParseResponse<Admin>(http_client_->Perform(requests_.ModifyAdmin(username, admin)));
 }
 
 Admin Api::RemoveAdmin(const std::string& username) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Delete(uri_ + "/api/admin/"s + username, {}, headers);
-
-  return ParseResponse<Admin>(response);
+  return ParseResponse<Admin>(http_client_->Perform(requests_.RemoveAdmin(username)));
 }
 
 Admins
 Api::GetAdmins(const GetAdminsParams& params) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/x-www-form-urlencoded");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string query;
-  std::vector<std::string> data;
-
-  if (params.limit) {
-    data.push_back("limit=" + std::to_string(*params.limit));
-  }
-
-  if (params.offset) {
-    data.push_back("offset=" + std::to_string(*params.offset));
-  }
-
-  if (params.username && !params.username->empty()) {
-    for (const auto& username : *params.username) {
-      data.push_back("username=" + username);
-    }
-  }
-
-  for (const auto& query_element : data) {
-    query += query_element + "&";
-  }
-
-  if (!query.empty()) {
-    query.pop_back();
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/admins/?" + query, headers);
-
-  return ParseResponse<Admins>(response);
+  return ParseResponse<Admins>(http_client_->Perform(requests_.GetAdmins(params)));
 }
 
 System
 Api::GetSystemStats() const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/system/"s, headers);
-
-  return ParseResponse<System>(response);
+  return ParseResponse<System>(http_client_->Perform(requests_.GetSystemStats()));
 }
 
 Inbounds
 Api::GetInbounds() const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/inbounds/"s, headers);
-
-  if (response.status_code != static_cast<int>(RestApiStatusCode::kOk)) {
-    throw MarzbanServerResponseError{response};
-  }
-
-  return ParseResponse<Inbounds>(response);
+  return ParseResponse<Inbounds>(http_client_->Perform(requests_.GetInbounds()));
 }
 
 Hosts Api::GetHosts() const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/hosts/"s, headers);
-
-  return ParseResponse<Hosts>(response);
+  return ParseResponse<Hosts>(http_client_->Perform(requests_.GetHosts()));
 }
 
 Hosts Api::ModifyHosts(const Hosts& hosts) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/json");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string modify_hosts_request;
-  const auto error_ctx = glz::write_json(hosts, modify_hosts_request);
-
-  if (error_ctx) {
-    throw ToObjectFromJsonError{error_ctx};
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Put(uri_ + "/api/hosts/"s, modify_hosts_request, headers);
-
-  return ParseResponse<Hosts>(response);
+  return ParseResponse<Hosts>(http_client_->Perform(requests_.ModifyHosts(hosts)));
 }
 
 User Api::AddUser(const User& user) const {
-  if (!user.username.has_value()) {
-    throw UsernameFieldInUserWasNotSet{"'username' field must be set"};
-  }
-
-  if (!user.status.has_value()) {
-    throw StatusFieldInUserWasNotSet{"'status' field must be set"};
-  }
-
-  const auto is_valid_status =
-    (*user.status == status_values::kActive || *user.status == status_values::kOnHold);
-
-  if (!is_valid_status) {
-    const auto allowed_values = std::vector{
-      std::string{status_values::kActive},
-      std::string{status_values::kOnHold}};
-
-    throw UnexpectedStatusFieldValueInUser{*user.status, allowed_values};
-  }
-
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/json");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string json_request;
-  const auto error_ctx = glz::write_json(user, json_request);
-
-  if (error_ctx) {
-    throw ToObjectFromJsonError{error_ctx};
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Post(uri_ + "/api/user/"s, json_request, headers);
-
-  return ParseResponse<User>(response);
+  return ParseResponse<User>(http_client_->Perform(requests_.AddUser(user)));
 }
 
 User Api::GetUser(const std::string& username) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/json");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/user/"s + username, headers);
-
-  if (response.status_code != static_cast<int>(RestApiStatusCode::kOk)) {
-    throw MarzbanServerResponseError{response};
-  }
-
-  return ParseResponse<User>(response);
+  return ParseResponse<User>(http_client_->Perform(requests_.GetUser(username)));
 }
 
 User Api::ModifyUser(const std::string& username, const User& modified_user) const {
-  if (!modified_user.username) {
-    throw UsernameFieldInUserWasNotSet{"'username' field must be set"};
-  }
-
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/json");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string json_request;
-  const auto error_ctx = glz::write_json(modified_user, json_request);
-
-  if (error_ctx) {
-    throw ToObjectFromJsonError{error_ctx};
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Put(uri_ + "/api/user/"s + username, json_request, headers);
-
-  return ParseResponse<User>(response);
+  return ParseResponse<User>(http_client_->Perform(requests_.ModifyUser(username, modified_user)));
 }
 
 HttpClient::Response
 Api::RemoveUser(const std::string& username) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Delete(uri_ + "/api/user/"s + username, {}, headers);
-
-  return response;
+  return http_client_->Perform(requests_.RemoveUser(username));
 }
 
 User Api::ResetUserDataUsage(const std::string& username) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Post(uri_ + "/api/user/"s + username + "/reset", {}, headers);
-
-  return ParseResponse<User>(response);
+  return ParseResponse<User>(http_client_->Perform(requests_.ResetUserDataUsage(username)));
 }
 
 User Api::RevokeUserSubscription(const std::string& username) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Post(uri_ + "/api/user/"s + username + "/revoke_sub", {}, headers);
-
-  return ParseResponse<User>(response);
+  return ParseResponse<User>(http_client_->Perform(requests_.RevokeUserSubscription(username)));
 }
 
 Users Api::GetUsers(const GetUsersParams& params) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/x-www-form-urlencoded");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string query;
-  std::vector<std::string> data;
-
-  if (params.limit) {
-    data.push_back("limit=" + std::to_string(*params.limit));
-  }
-
-  if (params.offset) {
-    data.push_back("offset=" + std::to_string(*params.offset));
-  }
-
-  if (params.sort) {
-    data.push_back("sort=" + *params.sort);
-  }
-
-  if (params.status) {
-    data.push_back("status=" + *params.status);
-  }
+  return ParseResponse<Users>(http_client_->Perform(requests_.GetUsers(params)));
+}
 
-  if (params.username && !params.username->empty()) {
-    for (const auto& username : *params.username) {
-      data.push_back("username=" + username);
-    }
-  }
+std::string Api::GetUsersJson(const GetUsersParams& params) const {
+  auto response = http_client_->Perform(requests_.GetUsers(params));
 
-  if (!data.empty()) {
-    query += "?";
+  if (response.status_code != static_cast<int>(RestApiStatusCode::kOk) || response.body.empty()) {
+    throw MarzbanServerResponseError{std::move(response)};
   }
 
-  for (const auto& query_element : data) {
-    query += query_element + "&";
-  }
+  return std::move(response.body);
+}
 
-  if (!query.empty()) {
-    query.pop_back();
-  }
+uint64_t Api::StreamUsers(const GetUsersParams& params, const UserCallback& callback) const {
+  UsersStreamParser parser{callback};
 
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/users" + query, headers);
+  auto request = requests_.GetUsers(params);
+  request.body_sink = [&parser](std::string_view chunk) { parser.Feed(chunk); };
 
-  return ParseResponse<Users>(response);
+  CheckResponse(http_client_->Perform(request));
+  return parser.Finish();
 }
 
 HttpClient::Response
 Api::ResetUsersDataUsage() const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Post(uri_ + "/api/users/reset"s, {}, headers);
-
-  if (response.status_code != static_cast<int>(RestApiStatusCode::kOk)) {
-    throw MarzbanServerResponseError{response};
-  }
-
-  return response;
+  return CheckResponse(http_client_->Perform(requests_.ResetUsersDataUsage()));
 }
 
 UserUsage
 Api::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end) const {
-  HttpHeaders headers;
-  headers.Add("Content-Type", "application/x-www-form-urlencoded");
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  auto query = "start=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", start);
-
-  if (end != TimePoint{}) {
-    query += "&end=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", end);
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/user/"s + username + "/usage/?" + query, headers);
+  return ParseResponse<UserUsage>(http_client_->Perform(requests_.GetUserUsage(username, start, end)));
+}
 
-  return ParseResponse<UserUsage>(response);
+UsersUsage
+Api::GetUsersUsage(const TimePoint& start, const TimePoint& end, const std::vector<std::string>& admins) const {
+  return ParseResponse<UsersUsage>(http_client_->Perform(requests_.GetUsersUsage(start, end, admins)));
 }
 
 User Api::SetOwner(const std::string& username, const std::string& admin_username) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  HttpClient http_client;
-  const auto response = http_client.Put(uri_ + "/api/user/"s + username + "/set-owner/?admin_username=" + admin_username, {}, headers);
-
-  return ParseResponse<User>(response);
+  return ParseResponse<User>(http_client_->Perform(requests_.SetOwner(username, admin_username)));
 }
 
 UserList
 Api::GetExpiredUsers(const ExpiredUsersParams& params) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
-
-  std::string query;
-
-  if (params.before) {
-    query = "?expired_before=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", *params.before);
-  }
-
-  if (params.after) {
-    if (!query.empty()) {
-      query += '&';
-    }
-
-    query = "expired_after=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", *params.after);
-  }
-
-  HttpClient http_client;
-  const auto response = http_client.Get(uri_ + "/api/users/expired/"s + query, headers);
-
-  return ParseResponse<UserList>(response);
+  return ParseResponse<UserList>(http_client_->Perform(requests_.GetExpiredUsers(params)));
 }
 
 UserList
 Api::DeleteExpiredUsers(const ExpiredUsersParams& params) const {
-  HttpHeaders headers;
-  headers.Add("Authorization", token_type_ + " " + access_token_);
+  return ParseResponse<UserList>(http_client_->Perform(requests_.DeleteExpiredUsers(params)));
+}
 
-  std::string query;
+ApiResult<User>
+Api::TryGetUser(const std::string& username) const {
+  return TryParseResponse<User>(http_client_->Perform(requests_.GetUser(username)));
+}
 
-  if (params.before) {
-    query = "?expired_before=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", *params.before);
-  }
+ApiResult<User>
+Api::TryAddUser(const User& user) const {
+  return TryParseResponse<User>(http_client_->Perform(requests_.AddUser(user)));
+}
 
-  if (params.after) {
-    if (!query.empty()) {
-      query += '&';
-    }
+ApiResult<User>
+Api::TryModifyUser(const std::string& username, const User& modified_user) const {
+  return TryParseResponse<User>(http_client_->Perform(requests_.ModifyUser(username, modified_user)));
+}
 
-    query = "expired_after=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", *params.after);
-  }
+ApiResult<void>
+Api::TryRemoveUser(const std::string& username) const {
+  auto response = http_client_->Perform(requests_.RemoveUser(username));
 
-  HttpClient http_client;
-  const auto response = http_client.Delete(uri_ + "/api/users/expired/"s + query, {}, headers);
+  if (response.status_code != static_cast<int>(RestApiStatusCode::kOk)) {
+    return std::unexpected{ApiError::Status(std::move(response))};
+  }
 
-  return ParseResponse<UserList>(response);
+  return {};
 }
 
-Api::Api(std::string uri, std::string token_type, std::string access_token)
-    : uri_{std::move(uri)},
-      token_type_{std::move(token_type)},
-      access_token_{std::move(access_token)} {}
+Api::Api(std::string uri, std::string token_type, std::string access_token, HttpClient::Ptr http_client)
+    : requests_{std::move(uri), std::move(token_type), std::move(access_token)},
+      http_client_{std::move(http_client)} {}
 
 }// namespace marzbanpp
@@ -8,12 +8,13 @@ namespace {
 using namespace marzbanpp;
 
 auto WrapPossiblyUnauthorizedCall(
-  const std::string& uri,
-  const std::string& username,
-  const std::string& password,
+  const AdminTokenRefresher& token_refresher,
   const IApi::Ptr& api,
   const auto& invocable,
   auto&&... args) {
+  token_refresher.RefreshIfExpiring(*api);
+  const auto token_generation = token_refresher.Generation();
+
   try {
     return (api.get()->*invocable)(std::forward<decltype(args)>(args)...);
   } catch (const MarzbanServerResponseError& ex) {
@@ -21,20 +22,47 @@ auto WrapPossiblyUnauthorizedCall(
       throw;
     }
 
-    api->SetAdminToken(Api::GetAdminToken(uri, username, password));
+    token_refresher.Refresh(*api, token_generation);
     return (api.get()->*invocable)(std::forward<decltype(args)>(args)...);
   }
 }
 
+//
+// The same for Try* methods which return 401 as ApiError instead of throwing it.
+//
+auto WrapPossiblyUnauthorizedTry(
+  const AdminTokenRefresher& token_refresher,
+  const IApi::Ptr& api,
+  const auto& invocable,
+  auto&&... args) {
+  token_refresher.RefreshIfExpiring(*api);
+  const auto token_generation = token_refresher.Generation();
+
+  auto result = (api.get()->*invocable)(args...);
+
+  if (result || result.error().StatusCode() != 401) {
+    return result;
+  }
+
+  token_refresher.Refresh(*api, token_generation);
+  return (api.get()->*invocable)(std::forward<decltype(args)>(args)...);
+}
+
 }// namespace
 
 namespace marzbanpp {
 
 ApiDecorator::ApiDecorator(std::string uri, std::string username, std::string password)
-    : uri_{std::move(uri)},
-      username_{std::move(username)},
-      password_{std::move(password)} {
-  api_ = Api::AuthAndCreate(uri_, username_, password_);
+    : ApiDecorator{std::move(uri), std::move(username), std::move(password), std::make_shared<HttpClient>()} {}
+
+ApiDecorator::ApiDecorator(
+  std::string uri,
+  std::string username,
+  std::string password,
+  HttpClient::Ptr http_client,
+  TokenOptions token_options)
+    : token_refresher_{uri, std::move(username), std::move(password), http_client, token_options} {
+  api_ = Api::Create(std::move(uri), token_refresher_.Login(), std::move(http_client));
 }
 
 void
@@ -44,107 +72,142 @@ ApiDecorator::SetAdminToken(const AdminToken& token) {
 
 Admin
 ApiDecorator::GetCurrentAdmin() const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetCurrentAdmin);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetCurrentAdmin);
 }
 
 Admin
 ApiDecorator::CreateAdmin(const Admin& admin) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::CreateAdmin, admin);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::CreateAdmin, admin);
 }
 
 Admin
 ApiDecorator::ModifyAdmin(const std::string& username, const Admin& admin) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::ModifyAdmin, username, admin);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::ModifyAdmin, username, admin);
 }
 
 Admin
 ApiDecorator::RemoveAdmin(const std::string& username) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::RemoveAdmin, username);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::RemoveAdmin, username);
 }
 
 Admins
 ApiDecorator::GetAdmins(const GetAdminsParams& params) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetAdmins, std::move(params));
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetAdmins, std::move(params));
 }
 
 System
 ApiDecorator::GetSystemStats() const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetSystemStats);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetSystemStats);
 }
 
 Inbounds
 ApiDecorator::GetInbounds() const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetInbounds);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetInbounds);
 }
 
 Hosts
 ApiDecorator::GetHosts() const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetHosts);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetHosts);
 }
 
 Hosts
 ApiDecorator::ModifyHosts(const Hosts& hosts) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::ModifyHosts, hosts);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::ModifyHosts, hosts);
 }
 
 User
 ApiDecorator::AddUser(const User& user) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::AddUser, user);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::AddUser, user);
 }
 
 User
 ApiDecorator::GetUser(const std::string& username) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetUser, username);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetUser, username);
 }
 
 User
 ApiDecorator::ModifyUser(const std::string& username, const User& modified_user) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::ModifyUser, username, modified_user);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::ModifyUser, username, modified_user);
 }
 
 HttpClient::Response
 ApiDecorator::RemoveUser(const std::string& username) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::RemoveUser, username);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::RemoveUser, username);
 }
 
 User
 ApiDecorator::ResetUserDataUsage(const std::string& username) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::ResetUserDataUsage, username);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::ResetUserDataUsage, username);
 }
 
 User
 ApiDecorator::RevokeUserSubscription(const std::string& username) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::RevokeUserSubscription, username);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::RevokeUserSubscription, username);
 }
 
 Users
 ApiDecorator::GetUsers(const GetUsersParams& params) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetUsers, std::move(params));
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetUsers, std::move(params));
+}
+
+std::string
+ApiDecorator::GetUsersJson(const GetUsersParams& params) const {
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetUsersJson, params);
+}
+
+uint64_t
+ApiDecorator::StreamUsers(const GetUsersParams& params, const UserCallback& callback) const {
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::StreamUsers, params, callback);
 }
 
 HttpClient::Response
 ApiDecorator::ResetUsersDataUsage() const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::ResetUsersDataUsage);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::ResetUsersDataUsage);
 }
 
 UserUsage
 ApiDecorator::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetUserUsage, username, start, end);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetUserUsage, username, start, end);
+}
+
+UsersUsage
+ApiDecorator::GetUsersUsage(const TimePoint& start, const TimePoint& end, const std::vector<std::string>& admins) const {
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetUsersUsage, start, end, admins);
 }
 
 User
 ApiDecorator::SetOwner(const std::string& username, const std::string& admin_username) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::SetOwner, username, admin_username);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::SetOwner, username, admin_username);
 }
 
 UserList
 ApiDecorator::GetExpiredUsers(const ExpiredUsersParams& params) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::GetExpiredUsers, params);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::GetExpiredUsers, params);
 }
 
 UserList
 ApiDecorator::DeleteExpiredUsers(const ExpiredUsersParams& params) const {
-  return WrapPossiblyUnauthorizedCall(uri_, username_, password_, api_, &IApi::DeleteExpiredUsers, params);
+  return WrapPossiblyUnauthorizedCall(token_refresher_, api_, &IApi::DeleteExpiredUsers, params);
+}
+
+ApiResult<User>
+ApiDecorator::TryGetUser(const std::string& username) const {
+  return WrapPossiblyUnauthorizedTry(token_refresher_, api_, &IApi::TryGetUser, username);
+}
+
+ApiResult<User>
+ApiDecorator::TryAddUser(const User& user) const {
+  return WrapPossiblyUnauthorizedTry(token_refresher_, api_, &IApi::TryAddUser, user);
+}
+
+ApiResult<User>
+ApiDecorator::TryModifyUser(const std::string& username, const User& modified_user) const {
+  return WrapPossiblyUnauthorizedTry(token_refresher_, api_, &IApi::TryModifyUser, username, modified_user);
+}
+
+ApiResult<void>
+ApiDecorator::TryRemoveUser(const std::string& username) const {
+  return WrapPossiblyUnauthorizedTry(token_refresher_, api_, &IApi::TryRemoveUser, username);
 }
 
 }// namespace marzbanpp
@@ -0,0 +1,38 @@
+#include "marzbanpp/api_error.h"
+
+#include "marzbanpp/types/exceptions.h"
+
+namespace marzbanpp {
+
+ApiError ApiError::Status(HttpClient::Response response) noexcept {
+  return ApiError{Kind::kStatus, {}, std::move(response)};
+}
+
+ApiError ApiError::Parse(const glz::error_ctx& error_ctx, HttpClient::Response response) noexcept {
+  return ApiError{Kind::kParse, error_ctx, std::move(response)};
+}
+
+std::string ApiError::Message() const {
+  switch (kind_) {
+    case Kind::kStatus: return MarzbanServerResponseError::FormatResponse(response_);
+    case Kind::kParse: return glz::format_error(error_ctx_, response_.body);
+  }
+
+  return {};
+}
+
+void ApiError::Throw() && {
+  switch (kind_) {
+    case Kind::kStatus: throw MarzbanServerResponseError{std::move(response_)};
+    case Kind::kParse: throw FromJsonToObjectError{error_ctx_, std::move(response_)};
+  }
+
+  std::unreachable();
+}
+
+ApiError::ApiError(Kind kind, const glz::error_ctx& error_ctx, HttpClient::Response response) noexcept
+    : kind_{kind},
+      error_ctx_{error_ctx},
+      response_{std::move(response)} {}
+
+}// namespace marzbanpp
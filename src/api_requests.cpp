@@ -0,0 +1,418 @@
+#include "marzbanpp/api_requests.h"
+
+#include "marzbanpp/types/exceptions.h"
+#include "marzbanpp/types/user.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+std::string ToJson(const auto& value) {
+  std::string json;
+  const auto error_ctx = glz::write_json(value, json);
+
+  if (error_ctx) {
+    throw ToObjectFromJsonError{error_ctx};
+  }
+
+  return json;
+}
+
+std::string ExpiredUsersQuery(const ApiRequests::ExpiredUsersParams& params) {
+  std::string query;
+
+  if (params.before) {
+    query = "?expired_before=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", *params.before);
+  }
+
+  if (params.after) {
+    query += query.empty() ? '?' : '&';
+    query += "expired_after=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", *params.after);
+  }
+
+  return query;
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+ApiRequests::ApiRequests(std::string uri, std::string token_type, std::string access_token)
+    : uri_{std::move(uri)},
+      header_lists_{MakeHeaderLists(token_type + " " + access_token)} {}
+
+HttpRequest ApiRequests::GetAdminToken(
+  const std::string& uri,
+  const std::string& username,
+  const std::string& password) {
+  HttpRequest request;
+  request.endpoint = "GetAdminToken";
+  request.method = HttpMethod::kPost;
+  request.uri = uri + "/api/admin/token";
+  request.payload = fmt::format("username={}&password={}", username, password);
+  request.headers.Add("Content-Type", "application/x-www-form-urlencoded");
+
+  return request;
+}
+
+void ApiRequests::ValidateNewUser(const User& user) {
+  if (!user.username.has_value()) {
+    throw UsernameFieldInUserWasNotSet{"'username' field must be set"};
+  }
+
+  if (!user.status.has_value()) {
+    throw StatusFieldInUserWasNotSet{"'status' field must be set"};
+  }
+
+  const auto is_valid_status =
+    (*user.status == status_values::kActive || *user.status == status_values::kOnHold);
+
+  if (!is_valid_status) {
+    const auto allowed_values = std::vector{
+      std::string{status_values::kActive},
+      std::string{status_values::kOnHold}};
+
+    throw UnexpectedStatusFieldValueInUser{*user.status, allowed_values};
+  }
+}
+
+void ApiRequests::ValidateModifiedUser(const User& user) {
+  if (!user.username) {
+    throw UsernameFieldInUserWasNotSet{"'username' field must be set"};
+  }
+}
+
+void ApiRequests::SetAdminToken(const AdminToken& token) {
+  header_lists_.store(MakeHeaderLists(token.token_type + " " + token.access_token), std::memory_order_release);
+}
+
+HttpRequest ApiRequests::GetCurrentAdmin() const {
+  HttpRequest request;
+  request.endpoint = "GetCurrentAdmin";
+  request.uri = uri_ + "/api/admin"s;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::CreateAdmin(const Admin& admin) const {
+  HttpRequest request;
+  request.endpoint = "CreateAdmin";
+  request.method = HttpMethod::kPost;
+  request.uri = uri_ + "/api/admin"s;
+  request.payload = ToJson(admin);
+  request.headers = AuthorizedHeaders(ContentType::kJson);
+
+  return request;
+}
+
+HttpRequest ApiRequests::ModifyAdmin(const std::string& username, const Admin& admin) const {
+  HttpRequest request;
+  request.endpoint = "ModifyAdmin";
+  request.method = HttpMethod::kPut;
+  request.uri = uri_ + "/api/admin/"s + username;
+  request.payload = ToJson(admin);
+  request.headers = AuthorizedHeaders(ContentType::kJson);
+
+  return request;
+}
+
+HttpRequest ApiRequests::RemoveAdmin(const std::string& username) const {
+  HttpRequest request;
+  request.endpoint = "RemoveAdmin";
+  request.method = HttpMethod::kDelete;
+  request.uri = uri_ + "/api/admin/"s + username;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetAdmins(const GetAdminsParams& params) const {
+  std::string query;
+  std::vector<std::string> data;
+
+  if (params.limit) {
+    data.push_back("limit=" + std::to_string(*params.limit));
+  }
+
+  if (params.offset) {
+    data.push_back("offset=" + std::to_string(*params.offset));
+  }
+
+  if (params.username && !params.username->empty()) {
+    for (const auto& username : *params.username) {
+      data.push_back("username=" + username);
+    }
+  }
+
+  for (const auto& query_element : data) {
+    query += query_element + "&";
+  }
+
+  if (!query.empty()) {
+    query.pop_back();
+  }
+
+  HttpRequest request;
+  request.endpoint = "GetAdmins";
+  request.uri = uri_ + "/api/admins/?" + query;
+  request.headers = AuthorizedHeaders(ContentType::kForm);
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetSystemStats() const {
+  HttpRequest request;
+  request.endpoint = "GetSystemStats";
+  request.uri = uri_ + "/api/system/"s;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetInbounds() const {
+  HttpRequest request;
+  request.endpoint = "GetInbounds";
+  request.uri = uri_ + "/api/inbounds/"s;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetHosts() const {
+  HttpRequest request;
+  request.endpoint = "GetHosts";
+  request.uri = uri_ + "/api/hosts/"s;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::ModifyHosts(const Hosts& hosts) const {
+  HttpRequest request;
+  request.endpoint = "ModifyHosts";
+  request.method = HttpMethod::kPut;
+  request.uri = uri_ + "/api/hosts/"s;
+  request.payload = ToJson(hosts);
+  request.headers = AuthorizedHeaders(ContentType::kJson);
+
+  return request;
+}
+
+HttpRequest ApiRequests::AddUser(const User& user) const {
+  ValidateNewUser(user);
+
+  HttpRequest request;
+  request.endpoint = "AddUser";
+  request.method = HttpMethod::kPost;
+  request.uri = uri_ + "/api/user/"s;
+  request.payload = ToJson(user);
+  request.headers = AuthorizedHeaders(ContentType::kJson);
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetUser(const std::string& username) const {
+  HttpRequest request;
+  request.endpoint = "GetUser";
+  request.uri = uri_ + "/api/user/"s + username;
+  request.headers = AuthorizedHeaders(ContentType::kJson);
+
+  return request;
+}
+
+HttpRequest ApiRequests::ModifyUser(const std::string& username, const User& modified_user) const {
+  ValidateModifiedUser(modified_user);
+
+  HttpRequest request;
+  request.endpoint = "ModifyUser";
+  request.method = HttpMethod::kPut;
+  request.uri = uri_ + "/api/user/"s + username;
+  request.payload = ToJson(modified_user);
+  request.headers = AuthorizedHeaders(ContentType::kJson);
+
+  return request;
+}
+
+HttpRequest ApiRequests::RemoveUser(const std::string& username) const {
+  HttpRequest request;
+  request.endpoint = "RemoveUser";
+  request.method = HttpMethod::kDelete;
+  request.uri = uri_ + "/api/user/"s + username;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::ResetUserDataUsage(const std::string& username) const {
+  HttpRequest request;
+  request.endpoint = "ResetUserDataUsage";
+  request.method = HttpMethod::kPost;
+  request.uri = uri_ + "/api/user/"s + username + "/reset";
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::RevokeUserSubscription(const std::string& username) const {
+  HttpRequest request;
+  request.endpoint = "RevokeUserSubscription";
+  request.method = HttpMethod::kPost;
+  request.uri = uri_ + "/api/user/"s + username + "/revoke_sub";
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetUsers(const GetUsersParams& params) const {
+  std::string query;
+  std::vector<std::string> data;
+
+  if (params.limit) {
+    data.push_back("limit=" + std::to_string(*params.limit));
+  }
+
+  if (params.offset) {
+    data.push_back("offset=" + std::to_string(*params.offset));
+  }
+
+  if (params.sort) {
+    data.push_back("sort=" + *params.sort);
+  }
+
+  if (params.status) {
+    data.push_back("status=" + *params.status);
+  }
+
+  if (params.username && !params.username->empty()) {
+    for (const auto& username : *params.username) {
+      data.push_back("username=" + username);
+    }
+  }
+
+  if (!data.empty()) {
+    query += "?";
+  }
+
+  for (const auto& query_element : data) {
+    query += query_element + "&";
+  }
+
+  if (!query.empty()) {
+    query.pop_back();
+  }
+
+  HttpRequest request;
+  request.endpoint = "GetUsers";
+  request.uri = uri_ + "/api/users" + query;
+  request.headers = AuthorizedHeaders(ContentType::kForm);
+
+  return request;
+}
+
+HttpRequest ApiRequests::ResetUsersDataUsage() const {
+  HttpRequest request;
+  request.endpoint = "ResetUsersDataUsage";
+  request.method = HttpMethod::kPost;
+  request.uri = uri_ + "/api/users/reset"s;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end) const {
+  auto query = "start=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", start);
+
+  if (end != TimePoint{}) {
+    query += "&end=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", end);
+  }
+
+  HttpRequest request;
+  request.endpoint = "GetUserUsage";
+  request.uri = uri_ + "/api/user/"s + username + "/usage/?" + query;
+  request.headers = AuthorizedHeaders(ContentType::kForm);
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetUsersUsage(
+  const TimePoint& start,
+  const TimePoint& end,
+  const std::vector<std::string>& admins) const {
+  auto query = "start=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", start);
+
+  if (end != TimePoint{}) {
+    query += "&end=" + fmt::format("{:%Y-%m-%dT%H:%M:%S}", end);
+  }
+
+  for (const auto& admin : admins) {
+    query += "&admin=" + admin;
+  }
+
+  HttpRequest request;
+  request.endpoint = "GetUsersUsage";
+  request.uri = uri_ + "/api/users/usage/?"s + query;
+  request.headers = AuthorizedHeaders(ContentType::kForm);
+
+  return request;
+}
+
+HttpRequest ApiRequests::SetOwner(const std::string& username, const std::string& admin_username) const {
+  HttpRequest request;
+  request.endpoint = "SetOwner";
+  request.method = HttpMethod::kPut;
+  request.uri = uri_ + "/api/user/"s + username + "/set-owner/?admin_username=" + admin_username;
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::GetExpiredUsers(const ExpiredUsersParams& params) const {
+  HttpRequest request;
+  request.endpoint = "GetExpiredUsers";
+  request.uri = uri_ + "/api/users/expired/"s + ExpiredUsersQuery(params);
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+HttpRequest ApiRequests::DeleteExpiredUsers(const ExpiredUsersParams& params) const {
+  HttpRequest request;
+  request.endpoint = "DeleteExpiredUsers";
+  request.method = HttpMethod::kDelete;
+  request.uri = uri_ + "/api/users/expired/"s + ExpiredUsersQuery(params);
+  request.headers = AuthorizedHeaders();
+
+  return request;
+}
+
+std::shared_ptr<const ApiRequests::AuthorizedHeaderLists>
+ApiRequests::MakeHeaderLists(const std::string& authorization) {
+  auto lists = std::make_shared<AuthorizedHeaderLists>();
+
+  lists->json.Add("Content-Type", "application/json");
+  lists->form.Add("Content-Type", "application/x-www-form-urlencoded");
+
+  for (auto* headers : {&lists->none, &lists->json, &lists->form}) {
+    headers->Add("Authorization", authorization);
+  }
+
+  return lists;
+}
+
+HttpHeaders ApiRequests::AuthorizedHeaders(ContentType content_type) const {
+  const auto lists = header_lists_.load(std::memory_order_acquire);
+
+  switch (content_type) {
+    case ContentType::kJson:
+      return lists->json;
+    case ContentType::kForm:
+      return lists->form;
+    case ContentType::kNone:
+      break;
+  }
+
+  return lists->none;
+}
+
+}// namespace marzbanpp
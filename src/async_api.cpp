@@ -0,0 +1,328 @@
+#include "marzbanpp/async_api.h"
+
+#include "marzbanpp/api.h"
+#include "marzbanpp/parse_response.h"
+#include "marzbanpp/types/exceptions.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+template <typename T>
+void Execute(
+  const AsyncHttpClient& client,
+  const auto& make_request,
+  const auto& parse,
+  AsyncApi::Callback<T> callback) {
+  HttpRequest request;
+
+  try {
+    request = make_request();
+  } catch (...) {
+    callback(std::unexpected{std::current_exception()});
+    return;
+  }
+
+  client.Perform(std::move(request), [parse, callback = std::move(callback)](AsyncHttpClient::Result&& result) {
+    if (result.error) {
+      callback(std::unexpected{std::move(result.error)});
+      return;
+    }
+
+    if (result.code != CURLE_OK) {
+      callback(std::unexpected{std::make_exception_ptr(CurlError{result.code})});
+      return;
+    }
+
+    AsyncApi::Result<T> value;
+
+    try {
+      value = parse(std::move(result.response));
+    } catch (...) {
+      value = std::unexpected{std::current_exception()};
+    }
+
+    callback(std::move(value));
+  });
+}
+
+template <typename T>
+std::future<T> MakeFuture(const auto& start) {
+  auto promise = std::make_shared<std::promise<T>>();
+  auto future = promise->get_future();
+
+  start([promise](AsyncApi::Result<T>&& result) {
+    if (result) {
+      promise->set_value(std::move(*result));
+    } else {
+      promise->set_exception(result.error());
+    }
+  });
+
+  return future;
+}
+
+HttpClient::Response PassResponse(HttpClient::Response&& response) {
+  return std::move(response);
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+AsyncApi::Ptr
+AsyncApi::AuthAndCreate(const std::string& uri, const std::string& username, const std::string& password) {
+  return AuthAndCreate(uri, username, password, std::make_shared<AsyncHttpClient>());
+}
+
+AsyncApi::Ptr
+AsyncApi::AuthAndCreate(
+  const std::string& uri,
+  const std::string& username,
+  const std::string& password,
+  AsyncHttpClient::Ptr client) {
+  auto admin_token = Api::GetAdminToken(*client->Transport(), uri, username, password);
+
+  struct MakeSharedEnabler : AsyncApi {
+    MakeSharedEnabler(std::string uri, AdminToken token, AsyncHttpClient::Ptr client)
+        : AsyncApi(
+            std::move(uri),
+            std::move(token.token_type),
+            std::move(token.access_token),
+            std::move(client)) {}
+  };
+
+  return std::make_shared<MakeSharedEnabler>(uri, std::move(admin_token), std::move(client));
+}
+
+void
+AsyncApi::SetAdminToken(const AdminToken& token) {
+  requests_.SetAdminToken(token);
+}
+
+std::future<Admin>
+AsyncApi::GetCurrentAdmin() const {
+  return MakeFuture<Admin>([&](auto callback) { GetCurrentAdmin(std::move(callback)); });
+}
+
+std::future<Admin>
+AsyncApi::CreateAdmin(const Admin& admin) const {
+  return MakeFuture<Admin>([&](auto callback) { CreateAdmin(admin, std::move(callback)); });
+}
+
+std::future<Admin>
+AsyncApi::ModifyAdmin(const std::string& username, const Admin& admin) const {
+  return MakeFuture<Admin>([&](auto callback) { ModifyAdmin(username, admin, std::move(callback)); });
+}
+
+std::future<Admin>
+AsyncApi::RemoveAdmin(const std::string& username) const {
+  return MakeFuture<Admin>([&](auto callback) { RemoveAdmin(username, std::move(callback)); });
+}
+
+std::future<Admins>
+AsyncApi::GetAdmins(const GetAdminsParams& params) const {
+  return MakeFuture<Admins>([&](auto callback) { GetAdmins(params, std::move(callback)); });
+}
+
+std::future<System>
+AsyncApi::GetSystemStats() const {
+  return MakeFuture<System>([&](auto callback) { GetSystemStats(std::move(callback)); });
+}
+
+std::future<Inbounds>
+AsyncApi::GetInbounds() const {
+  return MakeFuture<Inbounds>([&](auto callback) { GetInbounds(std::move(callback)); });
+}
+
+std::future<Hosts>
+AsyncApi::GetHosts() const {
+  return MakeFuture<Hosts>([&](auto callback) { GetHosts(std::move(callback)); });
+}
+
+std::future<Hosts>
+AsyncApi::ModifyHosts(const Hosts& hosts) const {
+  return MakeFuture<Hosts>([&](auto callback) { ModifyHosts(hosts, std::move(callback)); });
+}
+
+std::future<User>
+AsyncApi::AddUser(const User& user) const {
+  return MakeFuture<User>([&](auto callback) { AddUser(user, std::move(callback)); });
+}
+
+std::future<User>
+AsyncApi::GetUser(const std::string& username) const {
+  return MakeFuture<User>([&](auto callback) { GetUser(username, std::move(callback)); });
+}
+
+std::future<User>
+AsyncApi::ModifyUser(const std::string& username, const User& modified_user) const {
+  return MakeFuture<User>([&](auto callback) { ModifyUser(username, modified_user, std::move(callback)); });
+}
+
+std::future<HttpClient::Response>
+AsyncApi::RemoveUser(const std::string& username) const {
+  return MakeFuture<HttpClient::Response>([&](auto callback) { RemoveUser(username, std::move(callback)); });
+}
+
+std::future<User>
+AsyncApi::ResetUserDataUsage(const std::string& username) const {
+  return MakeFuture<User>([&](auto callback) { ResetUserDataUsage(username, std::move(callback)); });
+}
+
+std::future<User>
+AsyncApi::RevokeUserSubscription(const std::string& username) const {
+  return MakeFuture<User>([&](auto callback) { RevokeUserSubscription(username, std::move(callback)); });
+}
+
+std::future<Users>
+AsyncApi::GetUsers(const GetUsersParams& params) const {
+  return MakeFuture<Users>([&](auto callback) { GetUsers(params, std::move(callback)); });
+}
+
+std::future<HttpClient::Response>
+AsyncApi::ResetUsersDataUsage() const {
+  return MakeFuture<HttpClient::Response>([&](auto callback) { ResetUsersDataUsage(std::move(callback)); });
+}
+
+std::future<UserUsage>
+AsyncApi::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end) const {
+  return MakeFuture<UserUsage>([&](auto callback) { GetUserUsage(username, start, end, std::move(callback)); });
+}
+
+std::future<User>
+AsyncApi::SetOwner(const std::string& username, const std::string& admin_username) const {
+  return MakeFuture<User>([&](auto callback) { SetOwner(username, admin_username, std::move(callback)); });
+}
+
+std::future<UserList>
+AsyncApi::GetExpiredUsers(const ExpiredUsersParams& params) const {
+  return MakeFuture<UserList>([&](auto callback) { GetExpiredUsers(params, std::move(callback)); });
+}
+
+std::future<UserList>
+AsyncApi::DeleteExpiredUsers(const ExpiredUsersParams& params) const {
+  return MakeFuture<UserList>([&](auto callback) { DeleteExpiredUsers(params, std::move(callback)); });
+}
+
+void
+AsyncApi::GetCurrentAdmin(Callback<Admin> callback) const {
+  Execute<Admin>(*client_, [&] { return requests_.GetCurrentAdmin(); }, ParseResponse<Admin>, std::move(callback));
+}
+
+void
+AsyncApi::CreateAdmin(const Admin& admin, Callback<Admin> callback) const {
+  Execute<Admin>(*client_, [&] { return requests_.CreateAdmin(admin); }, ParseResponse<Admin>, std::move(callback));
+}
+
+void
+AsyncApi::ModifyAdmin(const std::string& username, const Admin& admin, Callback<Admin> callback) const {
+  Execute<Admin>(*client_, [&] { return requests_.ModifyAdmin(username, admin); }, ParseResponse<Admin>, std::move(callback));
+}
+
+void
+AsyncApi::RemoveAdmin(const std::string& username, Callback<Admin> callback) const {
+  Execute<Admin>(*client_, [&] { return requests_.RemoveAdmin(username); }, ParseResponse<Admin>, std::move(callback));
+}
+
+void
+AsyncApi::GetAdmins(const GetAdminsParams& params, Callback<Admins> callback) const {
+  Execute<Admins>(*client_, [&] { return requests_.GetAdmins(params); }, ParseResponse<Admins>, std::move(callback));
+}
+
+void
+AsyncApi::GetSystemStats(Callback<System> callback) const {
+  Execute<System>(*client_, [&] { return requests_.GetSystemStats(); }, ParseResponse<System>, std::move(callback));
+}
+
+void
+AsyncApi::GetInbounds(Callback<Inbounds> callback) const {
+  Execute<Inbounds>(*client_, [&] { return requests_.GetInbounds(); }, ParseResponse<Inbounds>, std::move(callback));
+}
+
+void
+AsyncApi::GetHosts(Callback<Hosts> callback) const {
+  Execute<Hosts>(*client_, [&] { return requests_.GetHosts(); }, ParseResponse<Hosts>, std::move(callback));
+}
+
+void
+AsyncApi::ModifyHosts(const Hosts& hosts, Callback<Hosts> callback) const {
+  Execute<Hosts>(*client_, [&] { return requests_.ModifyHosts(hosts); }, ParseResponse<Hosts>, std::move(callback));
+}
+
+void
+AsyncApi::AddUser(const User& user, Callback<User> callback) const {
+  Execute<User>(*client_, [&] { return requests_.AddUser(user); }, ParseResponse<User>, std::move(callback));
+}
+
+void
+AsyncApi::GetUser(const std::string& username, Callback<User> callback) const {
+  Execute<User>(*client_, [&] { return requests_.GetUser(username); }, ParseResponse<User>, std::move(callback));
+}
+
+void
+AsyncApi::ModifyUser(const std::string& username, const User& modified_user, Callback<User> callback) const {
+  Execute<User>(*client_, [&] { return requests_.ModifyUser(username, modified_user); }, ParseResponse<User>, std::move(callback));
+}
+
+void
+AsyncApi::RemoveUser(const std::string& username, Callback<HttpClient::Response> callback) const {
+  Execute<HttpClient::Response>(*client_, [&] { return requests_.RemoveUser(username); }, PassResponse, std::move(callback));
+}
+
+void
+AsyncApi::ResetUserDataUsage(const std::string& username, Callback<User> callback) const {
+  Execute<User>(*client_, [&] { return requests_.ResetUserDataUsage(username); }, ParseResponse<User>, std::move(callback));
+}
+
+void
+AsyncApi::RevokeUserSubscription(const std::string& username, Callback<User> callback) const {
+  Execute<User>(*client_, [&] { return requests_.RevokeUserSubscription(username); }, ParseResponse<User>, std::move(callback));
+}
+
+void
+AsyncApi::GetUsers(const GetUsersParams& params, Callback<Users> callback) const {
+  Execute<Users>(*client_, [&] { return requests_.GetUsers(params); }, ParseResponse<Users>, std::move(callback));
+}
+
+void
+AsyncApi::ResetUsersDataUsage(Callback<HttpClient::Response> callback) const {
+  Execute<HttpClient::Response>(*client_, [&] { return requests_.ResetUsersDataUsage(); }, CheckResponse, std::move(callback));
+}
+
+void
+AsyncApi::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end, Callback<UserUsage> callback) const {
+  Execute<UserUsage>(*client_, [&] { return requests_.GetUserUsage(username, start, end); }, ParseResponse<UserUsage>, std::move(callback));
+}
+
+void
+AsyncApi::SetOwner(const std::string& username, const std::string& admin_username, Callback<User> callback) const {
+  Execute<User>(*client_, [&] { return requests_.SetOwner(username, admin_username); }, ParseResponse<User>, std::move(callback));
+}
+
+void
+AsyncApi::GetExpiredUsers(const ExpiredUsersParams& params, Callback<UserList> callback) const {
+  Execute<UserList>(*client_, [&] { return requests_.GetExpiredUsers(params); }, ParseResponse<UserList>, std::move(callback));
+}
+
+void
+AsyncApi::DeleteExpiredUsers(const ExpiredUsersParams& params, Callback<UserList> callback) const {
+  Execute<UserList>(*client_, [&] { return requests_.DeleteExpiredUsers(params); }, ParseResponse<UserList>, std::move(callback));
+}
+
+UserRange
+AsyncApi::IterateUsers(const GetUsersParams& params, uint64_t page_size, size_t prefetch_depth) const {
+  auto fetch_page = [this](const GetUsersParams& page_params) { return GetUsers(page_params); };
+  return UserRange{std::move(fetch_page), params, page_size, prefetch_depth};
+}
+
+const AsyncHttpClient::Ptr&
+AsyncApi::Client() const noexcept {
+  return client_;
+}
+
+AsyncApi::AsyncApi(std::string uri, std::string token_type, std::string access_token, AsyncHttpClient::Ptr client)
+    : requests_{std::move(uri), std::move(token_type), std::move(access_token)},
+      client_{std::move(client)} {}
+
+}// namespace marzbanpp
@@ -0,0 +1,243 @@
+#include "marzbanpp/net/async_http_client.h"
+
+#include "marzbanpp/types/exceptions.h"
+
+namespace {
+
+constexpr int kPollTimeoutMs = 1000;
+// queued requests wait for the limiter, so it's polled more often
+constexpr int kThrottledPollTimeoutMs = 10;
+
+}// namespace
+
+namespace marzbanpp {
+
+AsyncHttpClient::AsyncHttpClient() : AsyncHttpClient{std::make_shared<HttpClient>()} {}
+
+AsyncHttpClient::AsyncHttpClient(HttpClient::Ptr http_client)
+    : http_client_{std::move(http_client)},
+      transport_{http_client_.get()},
+      multi_{curl_multi_init()},
+      in_flight_{0} {
+  Start();
+}
+
+AsyncHttpClient::AsyncHttpClient(const HttpClient& transport)
+    : transport_{&transport},
+      multi_{curl_multi_init()},
+      in_flight_{0} {
+  Start();
+}
+
+void AsyncHttpClient::Start() {
+  if (!multi_) {
+    throw CurlInitializeError{"curl_multi_init() failed"};
+  }
+
+  const auto& options = transport_->options_;
+
+  curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+  if (options.max_host_connections > 0) {
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(options.max_host_connections));
+  }
+
+  loop_ = std::jthread{[this](std::stop_token stop_token) { Run(std::move(stop_token)); }};
+}
+
+AsyncHttpClient::~AsyncHttpClient() {
+  loop_.request_stop();
+  curl_multi_wakeup(multi_);
+  loop_.join();
+
+  curl_multi_cleanup(multi_);
+}
+
+void AsyncHttpClient::Perform(HttpRequest request, Callback callback) const {
+  auto transfer = std::make_unique<Transfer>();
+  transfer->request = std::move(request);
+  transfer->callback = std::move(callback);
+
+  // counted before the loop can see the transfer, otherwise finishing it may run first and wrap the counter
+  in_flight_.fetch_add(1, std::memory_order_relaxed);
+
+  {
+    std::lock_guard _{queue_mutex_};
+    queue_.push_back(std::move(transfer));
+  }
+
+  curl_multi_wakeup(multi_);
+}
+
+size_t AsyncHttpClient::InFlight() const noexcept {
+  return in_flight_.load(std::memory_order_relaxed);
+}
+
+size_t AsyncHttpClient::Queued() const {
+  std::lock_guard _{queue_mutex_};
+  return queue_.size();
+}
+
+const HttpClient::Ptr& AsyncHttpClient::Transport() const noexcept {
+  return http_client_;
+}
+
+void AsyncHttpClient::Run(std::stop_token stop_token) {
+  while (!stop_token.stop_requested()) {
+    StartQueuedTransfers();
+
+    int running_handles = 0;
+    curl_multi_perform(multi_, &running_handles);
+
+    FinishCompletedTransfers();
+
+    curl_multi_poll(multi_, nullptr, 0, throttled_ ? kThrottledPollTimeoutMs : kPollTimeoutMs, nullptr);
+  }
+
+  std::vector<std::unique_ptr<Transfer>> queue;
+
+  {
+    std::lock_guard _{queue_mutex_};
+    queue.swap(queue_);
+  }
+
+  for (auto& transfer : queue) {
+    Finish(std::move(transfer), CURLE_ABORTED_BY_CALLBACK);
+  }
+
+  auto running = std::move(running_);
+
+  for (auto& [easy, transfer] : running) {
+    curl_multi_remove_handle(multi_, easy);
+    Finish(std::move(transfer), CURLE_ABORTED_BY_CALLBACK);
+  }
+}
+
+void AsyncHttpClient::StartQueuedTransfers() {
+  std::vector<std::unique_ptr<Transfer>> queue;
+
+  {
+    std::lock_guard _{queue_mutex_};
+    queue.swap(queue_);
+  }
+
+  const auto& limiter = transport_->Limiter();
+  auto it = queue.begin();
+
+  for (; it != queue.end(); ++it) {
+    auto& transfer = *it;
+
+    if (limiter) {
+      if (!limiter->TryAcquire()) {
+        break;
+      }
+
+      transfer->admitted = true;
+    }
+
+    transfer->started = IRequestLimiter::Clock::now();
+
+    try {
+      transfer->easy = transport_->AcquireHandle();
+    } catch (const CurlInitializeError&) {
+      Finish(std::move(transfer), CURLE_FAILED_INIT);
+      continue;
+    }
+
+    const auto& request = transfer->request;
+
+    transfer->receiver.easy = transfer->easy;
+    transfer->receiver.body_sink = &request.body_sink;
+
+    HttpClient::SetupHandle(
+      transfer->easy,
+      request.method,
+      request.uri,
+      request.payload,
+      request.headers,
+      request.follow_location,
+      transfer->receiver);
+
+    const auto result = curl_multi_add_handle(multi_, transfer->easy);
+
+    if (result != CURLM_OK) {
+      Finish(std::move(transfer), CURLE_FAILED_INIT);
+      continue;
+    }
+
+    CURL* easy = transfer->easy;
+    running_.emplace(easy, std::move(transfer));
+  }
+
+  throttled_ = it != queue.end();
+
+  if (throttled_) {
+    // not admitted transfers are returned to the front of the queue keeping their order
+    std::lock_guard _{queue_mutex_};
+    queue_.insert(queue_.begin(), std::make_move_iterator(it), std::make_move_iterator(queue.end()));
+  }
+}
+
+void AsyncHttpClient::FinishCompletedTransfers() {
+  int messages_left = 0;
+
+  while (CURLMsg* message = curl_multi_info_read(multi_, &messages_left)) {
+    if (message->msg != CURLMSG_DONE) {
+      continue;
+    }
+
+    CURL* easy = message->easy_handle;
+    const auto code = message->data.result;
+
+    curl_multi_remove_handle(multi_, easy);
+
+    auto it = running_.find(easy);
+    auto transfer = std::move(it->second);
+    running_.erase(it);
+
+    Finish(std::move(transfer), code);
+  }
+}
+
+void AsyncHttpClient::Finish(std::unique_ptr<Transfer> transfer, CURLcode code) {
+  if (transfer->admitted) {
+    IRequestLimiter::Outcome outcome;
+    outcome.latency = IRequestLimiter::Clock::now() - transfer->started;
+
+    if (!transfer->receiver.error) {
+      long status_code = 0;
+
+      if (transfer->easy) {
+        curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status_code);
+      }
+
+      outcome.overloaded = HttpClient::IsOverloaded(code, static_cast<int>(status_code));
+    }
+
+    transport_->Limiter()->Release(outcome);
+  }
+
+  if (transfer->easy) {
+    if (code == CURLE_OK) {
+      long status_code = 0;
+      code = curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &status_code);
+      transfer->receiver.response.status_code = static_cast<int>(status_code);
+    }
+
+    transport_->RecordTransfer(transfer->easy, transfer->request.endpoint, transfer->receiver.response);
+
+    transport_->ReleaseHandle(transfer->easy);
+    transfer->easy = nullptr;
+  }
+
+  in_flight_.fetch_sub(1, std::memory_order_relaxed);
+  auto& receiver = transfer->receiver;
+
+  try {
+    transfer->callback(Result{code, std::move(receiver.response), std::move(receiver.error)});
+  } catch (...) {
+    // there is nobody to pass it to on the loop thread, and it must keep serving other transfers
+  }
+}
+
+}// namespace marzbanpp
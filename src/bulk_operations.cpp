@@ -0,0 +1,139 @@
+#include "marzbanpp/bulk_operations.h"
+
+#include "marzbanpp/api_requests.h"
+#include "marzbanpp/parse_response.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+//
+// Validates every item before the first request is sent.
+// Items rejected by the validator get their error right away and are skipped later.
+//
+template <typename T, typename Item>
+std::vector<bool> Validate(std::span<const Item> items, const auto& validate, BulkResult<T>& result) {
+  std::vector<bool> rejected(items.size(), false);
+
+  for (size_t i = 0; i < items.size(); ++i) {
+    try {
+      validate(items[i]);
+    } catch (...) {
+      result.items[i] = std::unexpected{std::current_exception()};
+      rejected[i] = true;
+    }
+  }
+
+  return rejected;
+}
+
+template <typename T, typename Item>
+BulkResult<T> RunBulk(
+  std::span<const Item> items,
+  const BulkOptions& options,
+  const auto& validate,
+  const auto& call) {
+  const auto started = std::chrono::steady_clock::now();
+
+  BulkResult<T> result;
+  result.items.resize(items.size(), std::unexpected{std::exception_ptr{}});
+
+  const auto rejected = Validate(items, validate, result);
+
+  std::atomic<size_t> next{0};
+
+  const auto worker = [&]() {
+    for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < items.size();
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      if (rejected[i]) {
+        continue;
+      }
+
+      try {
+        result.items[i] = call(items[i]);
+      } catch (...) {
+        result.items[i] = std::unexpected{std::current_exception()};
+      }
+    }
+  };
+
+  {
+    const auto threads = std::clamp<size_t>(options.parallelism, 1, std::max<size_t>(items.size(), 1));
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+
+    for (size_t i = 1; i < threads; ++i) {
+      workers.emplace_back(worker);
+    }
+
+    worker();
+  }
+
+  for (const auto& item : result.items) {
+    ++(item ? result.succeeded : result.failed);
+  }
+
+  result.elapsed = std::chrono::steady_clock::now() - started;
+  return result;
+}
+
+constexpr auto kNoValidation = [](const auto&) {};
+
+}// namespace
+
+namespace marzbanpp {
+
+BulkResult<User> BulkAddUsers(const IApi::Ptr& api, std::span<const User> users, const BulkOptions& options) {
+  return RunBulk<User>(
+    users,
+    options,
+    [](const User& user) { ApiRequests::ValidateNewUser(user); },
+    [&api](const User& user) { return api->AddUser(user); });
+}
+
+BulkResult<User> BulkModifyUsers(
+  const IApi::Ptr& api,
+  std::span<const UserModification> modifications,
+  const BulkOptions& options) {
+  return RunBulk<User>(
+    modifications,
+    options,
+    [](const UserModification& modification) { ApiRequests::ValidateModifiedUser(modification.user); },
+    [&api](const UserModification& modification) { return api->ModifyUser(modification.username, modification.user); });
+}
+
+BulkResult<User> BulkSetOwners(
+  const IApi::Ptr& api,
+  std::span<const OwnerAssignment> assignments,
+  const BulkOptions& options) {
+  return RunBulk<User>(
+    assignments,
+    options,
+    kNoValidation,
+    [&api](const OwnerAssignment& assignment) { return api->SetOwner(assignment.username, assignment.admin_username); });
+}
+
+BulkResult<HttpClient::Response> BulkRemoveUsers(
+  const IApi::Ptr& api,
+  std::span<const std::string> usernames,
+  const BulkOptions& options) {
+  return RunBulk<HttpClient::Response>(
+    usernames,
+    options,
+    kNoValidation,
+    [&api](const std::string& username) { return CheckResponse(api->RemoveUser(username)); });
+}
+
+BulkResult<User> BulkResetUsersDataUsage(
+  const IApi::Ptr& api,
+  std::span<const std::string> usernames,
+  const BulkOptions& options) {
+  return RunBulk<User>(
+    usernames,
+    options,
+    kNoValidation,
+    [&api](const std::string& username) { return api->ResetUserDataUsage(username); });
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,189 @@
+#include "marzbanpp/co_api.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+template <typename T>
+class CallbackAwaiter final {
+ public:
+  using Start = std::function<void(AsyncApi::Callback<T>)>;
+
+  CallbackAwaiter(Start start, IScheduler& scheduler)
+      : start_{std::move(start)},
+        scheduler_{scheduler} {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    // the callback may resume and destroy the awaiting coroutine before start() returns,
+    // so members of this object must not be touched after the call
+    const auto start = std::move(start_);
+
+    start([this, handle](AsyncApi::Result<T>&& result) {
+      result_.emplace(std::move(result));
+      scheduler_.Schedule(handle);
+    });
+  }
+
+  T await_resume() {
+    auto& result = *result_;
+
+    if (!result) {
+      std::rethrow_exception(result.error());
+    }
+
+    return std::move(*result);
+  }
+
+ private:
+  Start start_;
+  IScheduler& scheduler_;
+  std::optional<AsyncApi::Result<T>> result_;
+};
+
+}// namespace
+
+namespace marzbanpp {
+
+CoApi::CoApi(AsyncApi::Ptr api, IScheduler::Ptr scheduler)
+    : api_{std::move(api)},
+      scheduler_{std::move(scheduler)} {}
+
+Task<Admin>
+CoApi::GetCurrentAdmin() const {
+  CallbackAwaiter<Admin> awaiter{[&](auto callback) { api_->GetCurrentAdmin(std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Admin>
+CoApi::CreateAdmin(Admin admin) const {
+  CallbackAwaiter<Admin> awaiter{[&](auto callback) { api_->CreateAdmin(admin, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Admin>
+CoApi::ModifyAdmin(std::string username, Admin admin) const {
+  CallbackAwaiter<Admin> awaiter{[&](auto callback) { api_->ModifyAdmin(username, admin, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Admin>
+CoApi::RemoveAdmin(std::string username) const {
+  CallbackAwaiter<Admin> awaiter{[&](auto callback) { api_->RemoveAdmin(username, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Admins>
+CoApi::GetAdmins(GetAdminsParams params) const {
+  CallbackAwaiter<Admins> awaiter{[&](auto callback) { api_->GetAdmins(params, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<System>
+CoApi::GetSystemStats() const {
+  CallbackAwaiter<System> awaiter{[&](auto callback) { api_->GetSystemStats(std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Inbounds>
+CoApi::GetInbounds() const {
+  CallbackAwaiter<Inbounds> awaiter{[&](auto callback) { api_->GetInbounds(std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Hosts>
+CoApi::GetHosts() const {
+  CallbackAwaiter<Hosts> awaiter{[&](auto callback) { api_->GetHosts(std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Hosts>
+CoApi::ModifyHosts(Hosts hosts) const {
+  CallbackAwaiter<Hosts> awaiter{[&](auto callback) { api_->ModifyHosts(hosts, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<User>
+CoApi::AddUser(User user) const {
+  CallbackAwaiter<User> awaiter{[&](auto callback) { api_->AddUser(user, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<User>
+CoApi::GetUser(std::string username) const {
+  CallbackAwaiter<User> awaiter{[&](auto callback) { api_->GetUser(username, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<User>
+CoApi::ModifyUser(std::string username, User modified_user) const {
+  CallbackAwaiter<User> awaiter{[&](auto callback) { api_->ModifyUser(username, modified_user, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<HttpClient::Response>
+CoApi::RemoveUser(std::string username) const {
+  CallbackAwaiter<HttpClient::Response> awaiter{[&](auto callback) { api_->RemoveUser(username, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<User>
+CoApi::ResetUserDataUsage(std::string username) const {
+  CallbackAwaiter<User> awaiter{[&](auto callback) { api_->ResetUserDataUsage(username, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<User>
+CoApi::RevokeUserSubscription(std::string username) const {
+  CallbackAwaiter<User> awaiter{[&](auto callback) { api_->RevokeUserSubscription(username, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<Users>
+CoApi::GetUsers(GetUsersParams params) const {
+  CallbackAwaiter<Users> awaiter{[&](auto callback) { api_->GetUsers(params, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<HttpClient::Response>
+CoApi::ResetUsersDataUsage() const {
+  CallbackAwaiter<HttpClient::Response> awaiter{[&](auto callback) { api_->ResetUsersDataUsage(std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<UserUsage>
+CoApi::GetUserUsage(std::string username, TimePoint start, TimePoint end) const {
+  CallbackAwaiter<UserUsage> awaiter{[&](auto callback) { api_->GetUserUsage(username, start, end, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<User>
+CoApi::SetOwner(std::string username, std::string admin_username) const {
+  CallbackAwaiter<User> awaiter{[&](auto callback) { api_->SetOwner(username, admin_username, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<UserList>
+CoApi::GetExpiredUsers(ExpiredUsersParams params) const {
+  CallbackAwaiter<UserList> awaiter{[&](auto callback) { api_->GetExpiredUsers(params, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+Task<UserList>
+CoApi::DeleteExpiredUsers(ExpiredUsersParams params) const {
+  CallbackAwaiter<UserList> awaiter{[&](auto callback) { api_->DeleteExpiredUsers(params, std::move(callback)); }, *scheduler_};
+  co_return co_await awaiter;
+}
+
+const AsyncApi::Ptr&
+CoApi::Api() const noexcept {
+  return api_;
+}
+
+const IScheduler::Ptr&
+CoApi::Scheduler() const noexcept {
+  return scheduler_;
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,225 @@
+#include "marzbanpp/coalescing_api.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+//
+// Different params produce different keys, the exact format doesn't matter.
+//
+std::string GetUsersKey(const IApi::GetUsersParams& params) {
+  std::string key = fmt::format(
+    "{}|{}|{}|{}|",
+    params.offset ? std::to_string(*params.offset) : "",
+    params.limit ? std::to_string(*params.limit) : "",
+    params.status.value_or(""),
+    params.sort.value_or(""));
+
+  if (params.username) {
+    for (const auto& username : *params.username) {
+      key += username;
+      key += '\0';
+    }
+  }
+
+  return key;
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+CoalescingApi::CoalescingApi(IApi::Ptr api) : api_{std::move(api)} {}
+
+template <typename T>
+T CoalescingApi::Coalesce(InFlight<T>& in_flight, const std::string& key, const auto& call) {
+  std::promise<T> promise;
+
+  std::unique_lock lock{in_flight.mutex};
+  auto [it, inserted] = in_flight.requests.try_emplace(key);
+
+  if (!inserted) {
+    ++it->second.waiters;
+    const auto result = it->second.result;
+    lock.unlock();
+
+    return result.get();
+  }
+
+  it->second.result = promise.get_future().share();
+  lock.unlock();
+
+  const auto complete = [&in_flight, &key]() {
+    // removed before the waiters are woken, so later calls don't get this result
+    std::lock_guard _{in_flight.mutex};
+
+    const auto found = in_flight.requests.find(key);
+    const auto waiters = found->second.waiters;
+    in_flight.requests.erase(found);
+
+    return waiters;
+  };
+
+  try {
+    T result = call();
+
+    if (complete() > 0) {
+      promise.set_value(result);
+    }
+
+    return result;
+  } catch (...) {
+    if (complete() > 0) {
+      promise.set_exception(std::current_exception());
+    }
+
+    throw;
+  }
+}
+
+void
+CoalescingApi::SetAdminToken(const AdminToken& token) {
+  api_->SetAdminToken(token);
+}
+
+Admin
+CoalescingApi::GetCurrentAdmin() const {
+  return Coalesce(admins_, {}, [this]() { return api_->GetCurrentAdmin(); });
+}
+
+Admin
+CoalescingApi::CreateAdmin(const Admin& admin) const {
+  return api_->CreateAdmin(admin);
+}
+
+Admin
+CoalescingApi::ModifyAdmin(const std::string& username, const Admin& admin) const {
+  return api_->ModifyAdmin(username, admin);
+}
+
+Admin
+CoalescingApi::RemoveAdmin(const std::string& username) const {
+  return api_->RemoveAdmin(username);
+}
+
+Admins
+CoalescingApi::GetAdmins(const GetAdminsParams& params) const {
+  return api_->GetAdmins(params);
+}
+
+System
+CoalescingApi::GetSystemStats() const {
+  return Coalesce(system_, {}, [this]() { return api_->GetSystemStats(); });
+}
+
+Inbounds
+CoalescingApi::GetInbounds() const {
+  return Coalesce(inbounds_, {}, [this]() { return api_->GetInbounds(); });
+}
+
+Hosts
+CoalescingApi::GetHosts() const {
+  return Coalesce(hosts_, {}, [this]() { return api_->GetHosts(); });
+}
+
+Hosts
+CoalescingApi::ModifyHosts(const Hosts& hosts) const {
+  return api_->ModifyHosts(hosts);
+}
+
+User
+CoalescingApi::AddUser(const User& user) const {
+  return api_->AddUser(user);
+}
+
+User
+CoalescingApi::GetUser(const std::string& username) const {
+  return Coalesce(users_, username, [this, &username]() { return api_->GetUser(username); });
+}
+
+User
+CoalescingApi::ModifyUser(const std::string& username, const User& modified_user) const {
+  return api_->ModifyUser(username, modified_user);
+}
+
+HttpClient::Response
+CoalescingApi::RemoveUser(const std::string& username) const {
+  return api_->RemoveUser(username);
+}
+
+User
+CoalescingApi::ResetUserDataUsage(const std::string& username) const {
+  return api_->ResetUserDataUsage(username);
+}
+
+User
+CoalescingApi::RevokeUserSubscription(const std::string& username) const {
+  return api_->RevokeUserSubscription(username);
+}
+
+Users
+CoalescingApi::GetUsers(const GetUsersParams& params) const {
+  return Coalesce(user_pages_, GetUsersKey(params), [this, &params]() { return api_->GetUsers(params); });
+}
+
+std::string
+CoalescingApi::GetUsersJson(const GetUsersParams& params) const {
+  return Coalesce(user_pages_json_, GetUsersKey(params), [this, &params]() { return api_->GetUsersJson(params); });
+}
+
+uint64_t
+CoalescingApi::StreamUsers(const GetUsersParams& params, const UserCallback& callback) const {
+  return api_->StreamUsers(params, callback);
+}
+
+HttpClient::Response
+CoalescingApi::ResetUsersDataUsage() const {
+  return api_->ResetUsersDataUsage();
+}
+
+UserUsage
+CoalescingApi::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end) const {
+  return api_->GetUserUsage(username, start, end);
+}
+
+UsersUsage
+CoalescingApi::GetUsersUsage(const TimePoint& start, const TimePoint& end, const std::vector<std::string>& admins) const {
+  return api_->GetUsersUsage(start, end, admins);
+}
+
+User
+CoalescingApi::SetOwner(const std::string& username, const std::string& admin_username) const {
+  return api_->SetOwner(username, admin_username);
+}
+
+UserList
+CoalescingApi::GetExpiredUsers(const ExpiredUsersParams& params) const {
+  return api_->GetExpiredUsers(params);
+}
+
+UserList
+CoalescingApi::DeleteExpiredUsers(const ExpiredUsersParams& params) const {
+  return api_->DeleteExpiredUsers(params);
+}
+
+ApiResult<User>
+CoalescingApi::TryGetUser(const std::string& username) const {
+  return api_->TryGetUser(username);
+}
+
+ApiResult<User>
+CoalescingApi::TryAddUser(const User& user) const {
+  return api_->TryAddUser(user);
+}
+
+ApiResult<User>
+CoalescingApi::TryModifyUser(const std::string& username, const User& modified_user) const {
+  return api_->TryModifyUser(username, modified_user);
+}
+
+ApiResult<void>
+CoalescingApi::TryRemoveUser(const std::string& username) const {
+  return api_->TryRemoveUser(username);
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,146 @@
+#include "marzbanpp/expired_users_sweeper.h"
+
+#include "marzbanpp/types/exceptions.h"
+
+namespace marzbanpp {
+
+ExpiredUsersSweeper::ExpiredUsersSweeper(IApi::Ptr api) : ExpiredUsersSweeper{std::move(api), Options{}} {}
+
+ExpiredUsersSweeper::ExpiredUsersSweeper(IApi::Ptr api, Options options)
+    : api_{std::move(api)},
+      options_{std::move(options)},
+      checkpoint_{options_.start} {
+  options_.users_per_window = std::max<uint64_t>(options_.users_per_window, 1);
+  options_.min_window = std::max(options_.min_window, std::chrono::seconds{1});
+  options_.max_window = std::max(options_.max_window, options_.min_window);
+  window_ = std::clamp(options_.initial_window, options_.min_window, options_.max_window);
+
+  LoadCheckpoint();
+}
+
+ExpiredUsersSweeper::~ExpiredUsersSweeper() {
+  loop_.request_stop();
+}
+
+ExpiredUsersSweeper::Report ExpiredUsersSweeper::Sweep(std::stop_token stop_token) {
+  std::lock_guard _{sweep_mutex_};
+
+  const auto until = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()) - options_.grace;
+
+  Report report;
+  report.swept_until = checkpoint_.load();
+
+  while (report.swept_until < until && !stop_token.stop_requested()) {
+    IApi::ExpiredUsersParams params;
+    params.after = report.swept_until;
+    params.before = std::min(report.swept_until + window_, until);
+
+    const auto expired = api_->GetExpiredUsers(params).size();
+    ++report.requests;
+
+    if (expired > options_.users_per_window && window_ > options_.min_window) {
+      const auto shrunk = std::chrono::seconds{
+        window_.count() * static_cast<int64_t>(options_.users_per_window) / static_cast<int64_t>(expired)};
+      window_ = std::max(options_.min_window, std::min(shrunk, window_ / 2));
+      continue;
+    }
+
+    if (expired > 0) {
+      if (!WaitUntil(next_delete_at_, stop_token)) {
+        break;
+      }
+
+      report.deleted += api_->DeleteExpiredUsers(params).size();
+      ++report.requests;
+      ++report.windows;
+      next_delete_at_ = Clock::now() + options_.min_delete_interval;
+    }
+
+    report.swept_until = *params.before;
+    SaveCheckpoint(report.swept_until);
+
+    if (expired * 2 < options_.users_per_window) {
+      window_ = std::min(options_.max_window, window_ * 2);
+    }
+  }
+
+  return report;
+}
+
+void ExpiredUsersSweeper::Start() {
+  if (!loop_.joinable()) {
+    loop_ = std::jthread{[this](std::stop_token stop_token) { Run(std::move(stop_token)); }};
+  }
+}
+
+ExpiredUsersSweeper::TimePoint ExpiredUsersSweeper::Checkpoint() const {
+  return checkpoint_.load();
+}
+
+std::exception_ptr ExpiredUsersSweeper::LastError() const {
+  std::lock_guard _{error_mutex_};
+  return last_error_;
+}
+
+void ExpiredUsersSweeper::Run(std::stop_token stop_token) {
+  do {
+    try {
+      const auto report = Sweep(stop_token);
+
+      {
+        std::lock_guard _{error_mutex_};
+        last_error_ = nullptr;
+      }
+
+      if (options_.on_sweep) {
+        options_.on_sweep(report);
+      }
+    } catch (...) {
+      std::lock_guard _{error_mutex_};
+      last_error_ = std::current_exception();
+    }
+  } while (WaitUntil(Clock::now() + options_.interval, stop_token));
+}
+
+bool ExpiredUsersSweeper::WaitUntil(Clock::time_point deadline, std::stop_token stop_token) {
+  std::unique_lock lock{wait_mutex_};
+  wait_condition_.wait_until(lock, stop_token, deadline, [] { return false; });
+
+  return !stop_token.stop_requested();
+}
+
+void ExpiredUsersSweeper::LoadCheckpoint() {
+  if (options_.checkpoint.empty()) {
+    return;
+  }
+
+  std::ifstream file{options_.checkpoint};
+  int64_t seconds = 0;
+
+  if (file >> seconds) {
+    checkpoint_ = TimePoint{std::chrono::seconds{seconds}};
+  }
+}
+
+void ExpiredUsersSweeper::SaveCheckpoint(TimePoint checkpoint) {
+  checkpoint_ = checkpoint;
+
+  if (options_.checkpoint.empty()) {
+    return;
+  }
+
+  auto temporary = options_.checkpoint;
+  temporary += ".tmp";
+
+  {
+    std::ofstream file{temporary, std::ios::trunc};
+
+    if (!(file << checkpoint.time_since_epoch().count() << '\n') || !file.flush()) {
+      throw MarzbanppError{"can't write checkpoint " + temporary.string()};
+    }
+  }
+
+  std::filesystem::rename(temporary, options_.checkpoint);
+}
+
+}// namespace marzbanpp
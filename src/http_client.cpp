@@ -1,5 +1,6 @@
 #include "marzbanpp/net/http_client.h"
 
+#include "marzbanpp/net/async_http_client.h"
 #include "marzbanpp/types/exceptions.h"
 #include "marzbanpp/finally.h"
 #include "marzbanpp/net/http_headers.h"
@@ -8,70 +9,103 @@ namespace {
 
 using namespace marzbanpp;
 
-enum ErrorCodes {
-  kErrorCreatingCurlHandle = -1,
-};
+constexpr long kHttpOk = 200;
+constexpr int kHttpTooManyRequests = 429;
+constexpr int kHttpInternalServerError = 500;
 
-size_t WriteResponseBodyCallback(void* buffer, size_t size, size_t nmemb, void* user_data) {
-  size_t total_size = size * nmemb;
+constexpr curl_off_t kMaxReservedBodySize = 64 * 1024 * 1024;
+// enough for headers of a typical Marzban response, so they are stored without reallocations
+constexpr size_t kReservedHeadersSize = 512;
 
-  HttpClient::Response* response = static_cast<HttpClient::Response*>(user_data);
-  response->body.append(static_cast<const char*>(buffer), total_size);
+std::string EncodeBase64(std::string_view data) {
+  constexpr std::string_view kAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-  return total_size;
+  std::string encoded;
+  encoded.reserve((data.size() + 2) / 3 * 4);
+
+  for (size_t i = 0; i < data.size(); i += 3) {
+    const auto remaining = data.size() - i;
+    uint32_t triple = static_cast<uint8_t>(data[i]) << 16;
+
+    if (remaining > 1) {
+      triple |= static_cast<uint8_t>(data[i + 1]) << 8;
+    }
+
+    if (remaining > 2) {
+      triple |= static_cast<uint8_t>(data[i + 2]);
+    }
+
+    encoded += kAlphabet[(triple >> 18) & 0x3F];
+    encoded += kAlphabet[(triple >> 12) & 0x3F];
+    encoded += remaining > 1 ? kAlphabet[(triple >> 6) & 0x3F] : '=';
+    encoded += remaining > 2 ? kAlphabet[triple & 0x3F] : '=';
+  }
+
+  return encoded;
 }
 
-size_t WriteResponseHeadersCallback(void* buffer, size_t size, size_t nmemb, void* user_data) {
-  size_t total_size = size * nmemb;
+void GlobalInitialize() {
+  static std::once_flag flag;
 
-  HttpClient::Response* response = static_cast<HttpClient::Response*>(user_data);
-  response->headers.push_back(static_cast<const char*>(buffer));
+  std::call_once(flag, []() {
+    const auto result = curl_global_init(CURL_GLOBAL_DEFAULT);
 
-  return total_size;
+    if (result != CURLE_OK) {
+      throw CurlError{result};
+    }
+  });
 }
 
 }// namespace
 
 namespace marzbanpp {
 
-HttpClient::HttpClient() {}
-
-HttpClient::Response
-HttpClient::Get(
-  const std::string& uri,
-  const HttpHeaders& headers,
-  bool follow_location) const {
-  CURL* easy = curl_easy_init();
+HttpClient::HttpClient() : HttpClient{Options{}} {}
 
-  if (!easy) {
-    throw CurlInitializeError{"curl_easy_init() failed"};
-  }
+HttpClient::HttpClient(const Options& options)
+    : options_{options},
+      share_{nullptr} {
+  GlobalInitialize();
 
-  Finally _{[easy]() noexcept { curl_easy_cleanup(easy); }};
+  idle_handles_.reserve(options_.max_idle_handles);
 
-  Response response;
+  share_ = curl_share_init();
 
-  curl_easy_setopt(easy, CURLOPT_URL, uri.data());
-  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers.Get());
-  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteResponseBodyCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, WriteResponseHeadersCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, follow_location);
+  if (!share_) {
+    throw CurlInitializeError{"curl_share_init() failed"};
+  }
 
-  CURLcode result = curl_easy_perform(easy);
+  curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, LockShare);
+  curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+  curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  // connection cache isn't shared: libcurl doesn't support using it from concurrent threads,
+  // every pooled handle keeps its own connection alive instead
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
+  if (Multiplexed()) {
+    multiplexer_ = std::unique_ptr<AsyncHttpClient>{new AsyncHttpClient{*this}};
   }
+}
 
-  result = curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status_code);
+HttpClient::~HttpClient() {
+  // its event loop uses handles and the share object
+  multiplexer_.reset();
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
+  // all easy handles using the share object must be destroyed before it
+  for (CURL* easy : idle_handles_) {
+    curl_easy_cleanup(easy);
   }
 
-  return response;
+  curl_share_cleanup(share_);
+}
+
+HttpClient::Response
+HttpClient::Get(
+  const std::string& uri,
+  const HttpHeaders& headers,
+  bool follow_location) const {
+  return Perform(HttpMethod::kGet, uri, {}, headers, std::nullopt, follow_location, nullptr, {});
 }
 
 HttpClient::Response
@@ -80,127 +114,373 @@ HttpClient::Put(
   const std::string& payload,
   const HttpHeaders& headers,
   bool follow_location) const {
-  CURL* easy = curl_easy_init();
-
-  if (!easy) {
-    throw CurlInitializeError{"curl_easy_init() failed"};
-  }
-
-  Finally _{[easy]() noexcept { curl_easy_cleanup(easy); }};
-
-  Response response;
-
-  curl_easy_setopt(easy, CURLOPT_URL, uri.data());
-  curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "PUT");
-  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers.Get());
-  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteResponseBodyCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, WriteResponseHeadersCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_POSTFIELDS, payload.data());
-  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, follow_location);
-
-  CURLcode result = curl_easy_perform(easy);
+  return Perform(HttpMethod::kPut, uri, payload, headers, std::nullopt, follow_location, nullptr, {});
+}
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
-  }
+HttpClient::Response
+HttpClient::Post(
+  const std::string& uri,
+  const std::string& payload,
+  const HttpHeaders& headers,
+  const std::optional<BasicAuth>& auth,
+  bool follow_location) const {
+  return Perform(HttpMethod::kPost, uri, payload, headers, auth, follow_location, nullptr, {});
+}
 
-  result = curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status_code);
+HttpClient::Response
+HttpClient::Delete(
+  const std::string& uri,
+  const std::string& payload,
+  const HttpHeaders& headers,
+  bool follow_location) const {
+  return Perform(HttpMethod::kDelete, uri, payload, headers, std::nullopt, follow_location, nullptr, {});
+}
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
+HttpClient::Response
+HttpClient::Perform(const HttpRequest& request) const {
+  if (multiplexer_) {
+    return PerformMultiplexed(request);
   }
 
-  return response;
+  return Perform(
+    request.method,
+    request.uri,
+    request.payload,
+    request.headers,
+    std::nullopt,
+    request.follow_location,
+    &request.body_sink,
+    request.endpoint);
 }
 
 HttpClient::Response
-HttpClient::Post(
+HttpClient::Perform(
+  HttpMethod method,
   const std::string& uri,
   const std::string& payload,
   const HttpHeaders& headers,
   const std::optional<BasicAuth>& auth,
-  bool follow_location) const {
-  CURL* easy = curl_easy_init();
+  bool follow_location,
+  const BodySink* body_sink,
+  std::string_view endpoint) const {
+  if (multiplexer_) {
+    // easy handles must not be performed next to the multiplexer's loop, so every entry point goes through it
+    HttpRequest request;
+    request.endpoint = endpoint;
+    request.method = method;
+    request.uri = uri;
+    request.payload = payload;
+    request.headers = headers;
+    request.follow_location = follow_location;
+
+    if (body_sink) {
+      request.body_sink = *body_sink;
+    }
+
+    if (auth) {
+      request.headers.Add("Authorization", "Basic " + EncodeBase64(auth->username + ":" + auth->password));
+    }
+
+    return PerformMultiplexed(request);
+  }
 
-  if (!easy) {
-    throw CurlInitializeError{"curl_easy_init() failed"};
+  const auto& limiter = options_.limiter;
+
+  if (limiter) {
+    limiter->Acquire();
   }
 
-  Finally _{[easy]() noexcept { curl_easy_cleanup(easy); }};
+  const auto started = IRequestLimiter::Clock::now();
+  IRequestLimiter::Outcome outcome{.overloaded = true};
 
-  Response response;
+  Finally release_limiter{[&limiter, &outcome, started]() noexcept {
+    if (limiter) {
+      outcome.latency = IRequestLimiter::Clock::now() - started;
+      limiter->Release(outcome);
+    }
+  }};
 
-  curl_easy_setopt(easy, CURLOPT_URL, uri.data());
-  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers.Get());
-  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteResponseBodyCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, WriteResponseHeadersCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_POSTFIELDS, payload.data());
-  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, follow_location);
+  CURL* easy = AcquireHandle();
+
+  Finally _{[this, easy]() noexcept { ReleaseHandle(easy); }};
+
+  Receiver receiver;
+  receiver.easy = easy;
+  receiver.body_sink = body_sink;
+  SetupHandle(easy, method, uri, payload, headers, follow_location, receiver);
+
+  std::string auth_string;
 
   if (auth) {
-    const auto auth_string = auth->username + ":" + auth->password;
+    auth_string = auth->username + ":" + auth->password;
     curl_easy_setopt(easy, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
     curl_easy_setopt(easy, CURLOPT_USERPWD, auth_string.c_str());
   }
 
   CURLcode result = curl_easy_perform(easy);
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
+  if (result == CURLE_OK) {
+    long status_code = 0;
+    result = curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status_code);
+    receiver.response.status_code = static_cast<int>(status_code);
   }
 
-  result = curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status_code);
+  RecordTransfer(easy, endpoint, receiver.response);
+
+  if (receiver.error) {
+    outcome.overloaded = false;
+    std::rethrow_exception(receiver.error);
+  }
 
   if (result != CURLE_OK) {
     throw CurlError{result};
   }
 
-  return response;
+  outcome.overloaded = IsOverloaded(result, receiver.response.status_code);
+  return std::move(receiver.response);
 }
 
-HttpClient::Response
-HttpClient::Delete(
+void HttpClient::SetupHandle(
+  CURL* easy,
+  HttpMethod method,
   const std::string& uri,
   const std::string& payload,
   const HttpHeaders& headers,
-  bool follow_location) const {
-  CURL* easy = curl_easy_init();
+  bool follow_location,
+  Receiver& receiver) {
+  curl_easy_setopt(easy, CURLOPT_URL, uri.data());
+  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers.Get());
+  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteBodyCallback);
+  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, WriteHeaderCallback);
+  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &receiver);
+  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &receiver);
+  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, static_cast<long>(follow_location));
+
+  switch (method) {
+    case HttpMethod::kGet: return;
+    case HttpMethod::kPost: break;
+    case HttpMethod::kPut: curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "PUT"); break;
+    case HttpMethod::kDelete: curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "DELETE"); break;
+  }
+
+  curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(payload.size()));
+  curl_easy_setopt(easy, CURLOPT_POSTFIELDS, payload.data());
+}
+
+void HttpClient::ReserveBody(CURL* easy, std::string& body) {
+  curl_off_t content_length = -1;
+
+  if (curl_easy_getinfo(easy, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &content_length) != CURLE_OK || content_length <= 0) {
+    return;
+  }
+
+  // the length is announced by the server, so it isn't trusted above a sane limit
+  body.reserve(static_cast<size_t>(std::min<curl_off_t>(content_length, kMaxReservedBodySize)));
+}
+
+const IRequestLimiter::Ptr& HttpClient::Limiter() const noexcept {
+  return options_.limiter;
+}
+
+const Metrics::Ptr& HttpClient::GetMetrics() const noexcept {
+  return options_.metrics;
+}
+
+void HttpClient::ReadTimings(CURL* easy, TransferTimings& timings) noexcept {
+  const auto read_time = [easy](CURLINFO info) {
+    curl_off_t value = 0;
+    curl_easy_getinfo(easy, info, &value);
+    return std::chrono::microseconds{value};
+  };
+
+  timings.namelookup = read_time(CURLINFO_NAMELOOKUP_TIME_T);
+  timings.connect = read_time(CURLINFO_CONNECT_TIME_T);
+  timings.appconnect = read_time(CURLINFO_APPCONNECT_TIME_T);
+  timings.starttransfer = read_time(CURLINFO_STARTTRANSFER_TIME_T);
+  timings.total = read_time(CURLINFO_TOTAL_TIME_T);
+
+  curl_off_t uploaded = 0;
+  curl_off_t downloaded = 0;
+  long request_size = 0;
+  long header_size = 0;
+  long new_connections = 0;
+
+  curl_easy_getinfo(easy, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+  curl_easy_getinfo(easy, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+  curl_easy_getinfo(easy, CURLINFO_REQUEST_SIZE, &request_size);
+  curl_easy_getinfo(easy, CURLINFO_HEADER_SIZE, &header_size);
+  curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &new_connections);
+
+  // CURLINFO_SIZE_DOWNLOAD_T counts body bytes before decompression
+  timings.bytes_sent = static_cast<uint64_t>(uploaded) + static_cast<uint64_t>(request_size);
+  timings.bytes_received = static_cast<uint64_t>(downloaded) + static_cast<uint64_t>(header_size);
+  timings.body_bytes_received = static_cast<uint64_t>(downloaded);
+  timings.new_connections = static_cast<uint64_t>(new_connections);
+}
+
+void HttpClient::RecordTransfer(CURL* easy, std::string_view endpoint, Response& response) const noexcept {
+  ReadTimings(easy, response.timings);
+
+  if (!options_.metrics) {
+    return;
+  }
+
+  try {
+    response.metrics = options_.metrics->Endpoint(endpoint);
+    response.metrics->RecordTransfer(response.status_code, response.timings);
+  } catch (...) {
+    // metrics must never fail the request
+  }
+}
+
+bool HttpClient::Multiplexed() const noexcept {
+  return options_.http_version == HttpVersion::kHttp2 || options_.http_version == HttpVersion::kHttp2PriorKnowledge;
+}
+
+HttpClient::Response
+HttpClient::PerformMultiplexed(const HttpRequest& request) const {
+  std::promise<AsyncHttpClient::Result> promise;
+  auto future = promise.get_future();
+
+  multiplexer_->Perform(request, [&promise](AsyncHttpClient::Result&& result) { promise.set_value(std::move(result)); });
+
+  auto result = future.get();
+
+  if (result.error) {
+    std::rethrow_exception(result.error);
+  }
+
+  if (result.code != CURLE_OK) {
+    throw CurlError{result.code};
+  }
+
+  return std::move(result.response);
+}
+
+bool HttpClient::IsOverloaded(CURLcode code, int status_code) noexcept {
+  if (code == CURLE_ABORTED_BY_CALLBACK) {
+    return false;
+  }
+
+  return code != CURLE_OK || status_code == kHttpTooManyRequests || status_code >= kHttpInternalServerError;
+}
+
+size_t HttpClient::WriteBodyCallback(void* buffer, size_t size, size_t nmemb, void* user_data) {
+  size_t total_size = size * nmemb;
+
+  Receiver* receiver = static_cast<Receiver*>(user_data);
+  const char* data = static_cast<const char*>(buffer);
+
+  // curl passes already decompressed data here
+  receiver->response.timings.body_bytes_decoded += total_size;
+
+  if (receiver->body_sink && *receiver->body_sink) {
+    long status_code = 0;
+    curl_easy_getinfo(receiver->easy, CURLINFO_RESPONSE_CODE, &status_code);
+
+    if (status_code == kHttpOk) {
+      try {
+        (*receiver->body_sink)(std::string_view{data, total_size});
+      } catch (...) {
+        receiver->error = std::current_exception();
+        return 0;
+      }
+
+      return total_size;
+    }
+  }
+
+  auto& body = receiver->response.body;
+
+  if (body.empty()) {
+    ReserveBody(receiver->easy, body);
+  }
+
+  body.append(data, total_size);
+
+  return total_size;
+}
+
+size_t HttpClient::WriteHeaderCallback(void* buffer, size_t size, size_t nmemb, void* user_data) {
+  size_t total_size = size * nmemb;
+
+  Receiver* receiver = static_cast<Receiver*>(user_data);
+  auto& headers = receiver->response.headers;
+
+  if (headers.empty()) {
+    headers.Reserve(kReservedHeadersSize);
+  }
+
+  headers.Append(std::string_view{static_cast<const char*>(buffer), total_size});
+
+  return total_size;
+}
+
+CURL* HttpClient::AcquireHandle() const {
+  CURL* easy = nullptr;
+
+  {
+    std::lock_guard _{idle_handles_mutex_};
+
+    if (!idle_handles_.empty()) {
+      easy = idle_handles_.back();
+      idle_handles_.pop_back();
+    }
+  }
 
   if (!easy) {
-    throw CurlInitializeError{"curl_easy_init() failed"};
+    easy = curl_easy_init();
   }
 
-  Finally _{[easy]() noexcept { curl_easy_cleanup(easy); }};
+  if (!easy) {
+    throw CurlInitializeError{"curl_easy_init() failed"};
+  }
 
-  Response response;
+  curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+  curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, static_cast<long>(options_.tcp_keep_alive));
 
-  curl_easy_setopt(easy, CURLOPT_URL, uri.data());
-  curl_easy_setopt(easy, CURLOPT_CUSTOMREQUEST, "DELETE");
-  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteResponseBodyCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, WriteResponseHeadersCallback);
-  curl_easy_setopt(easy, CURLOPT_HEADERDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &response);
-  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers.Get());
-  curl_easy_setopt(easy, CURLOPT_POSTFIELDS, payload.data());
-  curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, follow_location);
+  switch (options_.http_version) {
+    case HttpVersion::kDefault: break;
+    case HttpVersion::kHttp11: curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1); break;
+    case HttpVersion::kHttp2: curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS); break;
+    case HttpVersion::kHttp2PriorKnowledge: curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE); break;
+  }
 
-  CURLcode result = curl_easy_perform(easy);
+  if (Multiplexed()) {
+    // a new transfer waits for a connection which can be multiplexed instead of opening another one
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+  }
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
+  if (options_.accept_encoding) {
+    curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, options_.accept_encoding->c_str());
   }
 
-  result = curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status_code);
+  return easy;
+}
+
+void HttpClient::ReleaseHandle(CURL* easy) const noexcept {
+  // curl_easy_reset keeps the handle's connection alive, DNS cache and TLS session ids live in the share object
+  curl_easy_reset(easy);
 
-  if (result != CURLE_OK) {
-    throw CurlError{result};
+  {
+    std::lock_guard _{idle_handles_mutex_};
+
+    if (idle_handles_.size() < options_.max_idle_handles) {
+      idle_handles_.push_back(easy);
+      return;
+    }
   }
 
-  return response;
+  curl_easy_cleanup(easy);
+}
+
+void HttpClient::LockShare(CURL*, curl_lock_data data, curl_lock_access, void* user_data) {
+  static_cast<HttpClient*>(user_data)->share_mutexes_[data].lock();
+}
+
+void HttpClient::UnlockShare(CURL*, curl_lock_data data, void* user_data) {
+  static_cast<HttpClient*>(user_data)->share_mutexes_[data].unlock();
 }
 
 }// namespace marzbanpp
@@ -1,25 +1,55 @@
 #include "marzbanpp/net/http_headers.h"
 
-namespace marzbanpp {
+namespace {
 
-HttpHeaders::HttpHeaders()
-    : headers_{nullptr} {
-}
+struct SlistDeleter {
+  void operator()(curl_slist* headers) const noexcept {
+    curl_slist_free_all(headers);
+  }
+};
 
-HttpHeaders::~HttpHeaders() {
-  curl_slist_free_all(headers_);
+curl_slist* Append(curl_slist* headers, const char* header) {
+  curl_slist* appended = curl_slist_append(headers, header);
+
+  if (!appended) {
+    throw std::runtime_error("Cannot add header");
+  }
+
+  return appended;
 }
 
+}// namespace
+
+namespace marzbanpp {
+
+HttpHeaders::HttpHeaders() = default;
+
 void HttpHeaders::Add(const std::string& name, const std::string& value) {
-  headers_ = curl_slist_append(headers_, (name + ": " + value).data());
+  const auto header = name + ": " + value;
 
   if (!headers_) {
-    throw std::runtime_error("Cannot add header");
+    headers_.reset(Append(nullptr, header.data()), SlistDeleter{});
+    return;
+  }
+
+  if (headers_.use_count() > 1) {
+    std::unique_ptr<curl_slist, SlistDeleter> copy;
+
+    for (const curl_slist* it = headers_.get(); it; it = it->next) {
+      const auto appended = Append(copy.get(), it->data);
+      copy.release();
+      copy.reset(appended);
+    }
+
+    headers_.reset(copy.release(), SlistDeleter{});
   }
+
+  // the list is owned only by this object, so it's safe to append in place
+  Append(headers_.get(), header.data());
 }
 
 curl_slist* HttpHeaders::Get() const noexcept {
-  return headers_;
+  return headers_.get();
 }
 
 }// namespace marzbanpp
@@ -0,0 +1,63 @@
+#include "marzbanpp/iapi.h"
+
+#include "marzbanpp/parse_response.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+template <typename T>
+ApiResult<T> CatchApiError(const auto& call) {
+  try {
+    if constexpr (std::is_void_v<T>) {
+      call();
+      return {};
+    } else {
+      return call();
+    }
+  } catch (const MarzbanServerResponseError& ex) {
+    return std::unexpected{ApiError::Status(ex.Response())};
+  } catch (const FromJsonToObjectError& ex) {
+    return std::unexpected{ApiError::Parse(ex.ErrorContext(), ex.Response())};
+  }
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+User IApi::ModifyUserFields(const User& original, const User& modified) const {
+  auto patch = MakeUserPatch(original, modified);
+
+  if (patch.Empty()) {
+    return original;
+  }
+
+  if (!patch.user.username) {
+    throw UsernameFieldInUserWasNotSet{"'username' field must be set"};
+  }
+
+  return ModifyUser(*patch.user.username, patch.user);
+}
+
+ApiResult<User>
+IApi::TryGetUser(const std::string& username) const {
+  return CatchApiError<User>([&]() { return GetUser(username); });
+}
+
+ApiResult<User>
+IApi::TryAddUser(const User& user) const {
+  return CatchApiError<User>([&]() { return AddUser(user); });
+}
+
+ApiResult<User>
+IApi::TryModifyUser(const std::string& username, const User& modified_user) const {
+  return CatchApiError<User>([&]() { return ModifyUser(username, modified_user); });
+}
+
+ApiResult<void>
+IApi::TryRemoveUser(const std::string& username) const {
+  return CatchApiError<void>([&]() { CheckResponse(RemoveUser(username)); });
+}
+
+}// namespace marzbanpp
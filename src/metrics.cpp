@@ -0,0 +1,302 @@
+#include "marzbanpp/net/metrics.h"
+
+namespace {
+
+using namespace marzbanpp;
+using std::chrono::microseconds;
+
+constexpr size_t kLinearBits = std::countr_zero(LatencyHistogram::kSubBuckets);
+
+constexpr std::array kPrometheusBounds{
+  microseconds{1'000},
+  microseconds{2'500},
+  microseconds{5'000},
+  microseconds{10'000},
+  microseconds{25'000},
+  microseconds{50'000},
+  microseconds{100'000},
+  microseconds{250'000},
+  microseconds{500'000},
+  microseconds{1'000'000},
+  microseconds{2'500'000},
+  microseconds{5'000'000},
+  microseconds{10'000'000},
+  microseconds{30'000'000},
+};
+
+uint64_t Microseconds(microseconds value) noexcept {
+  return value.count() > 0 ? static_cast<uint64_t>(value.count()) : 0;
+}
+
+double Seconds(microseconds value) noexcept {
+  return std::chrono::duration<double>(value).count();
+}
+
+void UpdateMax(std::atomic<uint64_t>& max, uint64_t value) noexcept {
+  auto current = max.load(std::memory_order_relaxed);
+
+  while (current < value && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+void AppendHistogram(
+  std::string& out,
+  std::string_view name,
+  const std::map<std::string, EndpointMetrics::Snapshot>& endpoints,
+  LatencyHistogram::Snapshot EndpointMetrics::Snapshot::*histogram) {
+  fmt::format_to(std::back_inserter(out), "# TYPE {} histogram\n", name);
+
+  for (const auto& [endpoint, snapshot] : endpoints) {
+    const auto& values = snapshot.*histogram;
+
+    for (const auto bound : kPrometheusBounds) {
+      fmt::format_to(
+        std::back_inserter(out),
+        "{}_bucket{{endpoint=\"{}\",le=\"{}\"}} {}\n",
+        name,
+        endpoint,
+        Seconds(bound),
+        values.CountNotAbove(bound));
+    }
+
+    fmt::format_to(std::back_inserter(out), "{}_bucket{{endpoint=\"{}\",le=\"+Inf\"}} {}\n", name, endpoint, values.count);
+    fmt::format_to(std::back_inserter(out), "{}_sum{{endpoint=\"{}\"}} {}\n", name, endpoint, Seconds(values.sum));
+    fmt::format_to(std::back_inserter(out), "{}_count{{endpoint=\"{}\"}} {}\n", name, endpoint, values.count);
+  }
+}
+
+void AppendCounter(
+  std::string& out,
+  std::string_view name,
+  const std::map<std::string, EndpointMetrics::Snapshot>& endpoints,
+  uint64_t EndpointMetrics::Snapshot::*counter) {
+  fmt::format_to(std::back_inserter(out), "# TYPE {} counter\n", name);
+
+  for (const auto& [endpoint, snapshot] : endpoints) {
+    fmt::format_to(std::back_inserter(out), "{}{{endpoint=\"{}\"}} {}\n", name, endpoint, snapshot.*counter);
+  }
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+size_t LatencyHistogram::BucketIndex(uint64_t microseconds) noexcept {
+  if (microseconds < kSubBuckets) {
+    return static_cast<size_t>(microseconds);
+  }
+
+  const size_t exponent = static_cast<size_t>(std::bit_width(microseconds)) - 1;
+  const size_t sub_bucket = static_cast<size_t>(microseconds >> (exponent - kLinearBits)) & (kSubBuckets - 1);
+
+  return std::min((exponent - kLinearBits + 1) * kSubBuckets + sub_bucket, kBuckets - 1);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) noexcept {
+  if (index < kSubBuckets) {
+    return index;
+  }
+
+  const size_t shift = index / kSubBuckets - 1;
+  const uint64_t lower = (kSubBuckets + index % kSubBuckets) << shift;
+
+  return lower + (uint64_t{1} << shift) - 1;
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds value) noexcept {
+  const auto microseconds = Microseconds(value);
+
+  counts_[BucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(microseconds, std::memory_order_relaxed);
+  UpdateMax(max_, microseconds);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Take() const noexcept {
+  Snapshot snapshot;
+
+  // counters are read one by one, so under load the snapshot may be off by the requests recorded meanwhile
+  for (size_t i = 0; i < kBuckets; ++i) {
+    snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+  }
+
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.sum = std::chrono::microseconds{sum_.load(std::memory_order_relaxed)};
+  snapshot.max = std::chrono::microseconds{max_.load(std::memory_order_relaxed)};
+
+  return snapshot;
+}
+
+std::chrono::microseconds LatencyHistogram::Snapshot::Percentile(double q) const noexcept {
+  const uint64_t total = std::accumulate(counts.begin(), counts.end(), uint64_t{0});
+
+  if (total == 0) {
+    return {};
+  }
+
+  const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total))));
+  uint64_t seen = 0;
+
+  for (size_t i = 0; i < kBuckets; ++i) {
+    seen += counts[i];
+
+    if (seen >= rank) {
+      return std::min(std::chrono::microseconds{BucketUpperBound(i)}, max);
+    }
+  }
+
+  return max;
+}
+
+uint64_t LatencyHistogram::Snapshot::CountNotAbove(std::chrono::microseconds bound) const noexcept {
+  uint64_t result = 0;
+
+  for (size_t i = 0; i < kBuckets && BucketUpperBound(i) <= Microseconds(bound); ++i) {
+    result += counts[i];
+  }
+
+  return result;
+}
+
+void EndpointMetrics::RecordTransfer(int status_code, const TransferTimings& timings) noexcept {
+  requests_.fetch_add(1, std::memory_order_relaxed);
+  bytes_sent_.fetch_add(timings.bytes_sent, std::memory_order_relaxed);
+  bytes_received_.fetch_add(timings.bytes_received, std::memory_order_relaxed);
+  body_bytes_received_.fetch_add(timings.body_bytes_received, std::memory_order_relaxed);
+  body_bytes_decoded_.fetch_add(timings.body_bytes_decoded, std::memory_order_relaxed);
+  new_connections_.fetch_add(timings.new_connections, std::memory_order_relaxed);
+  latency_.Record(timings.total);
+
+  if (timings.starttransfer.count() > 0) {
+    const auto connected = std::max(timings.connect, timings.appconnect);
+
+    const std::array<std::chrono::microseconds, kPhases.size()> phases{
+      timings.namelookup,
+      timings.connect - timings.namelookup,
+      timings.appconnect.count() > 0 ? timings.appconnect - timings.connect : std::chrono::microseconds{},
+      timings.starttransfer - connected,
+      timings.total - timings.starttransfer,
+    };
+
+    for (size_t i = 0; i < phases.size(); ++i) {
+      phases_[i].fetch_add(Microseconds(phases[i]), std::memory_order_relaxed);
+    }
+  }
+
+  if (status_code < 200 || status_code >= 300) {
+    try {
+      std::lock_guard _{errors_mutex_};
+      ++errors_[status_code];
+    } catch (...) {
+      // losing an error count is better than failing the request
+    }
+  }
+}
+
+void EndpointMetrics::RecordParse(std::chrono::steady_clock::duration duration) noexcept {
+  parse_.Record(std::chrono::duration_cast<std::chrono::microseconds>(duration));
+}
+
+EndpointMetrics::Snapshot EndpointMetrics::Take() const {
+  Snapshot snapshot;
+  snapshot.requests = requests_.load(std::memory_order_relaxed);
+  snapshot.bytes_sent = bytes_sent_.load(std::memory_order_relaxed);
+  snapshot.bytes_received = bytes_received_.load(std::memory_order_relaxed);
+  snapshot.body_bytes_received = body_bytes_received_.load(std::memory_order_relaxed);
+  snapshot.body_bytes_decoded = body_bytes_decoded_.load(std::memory_order_relaxed);
+  snapshot.new_connections = new_connections_.load(std::memory_order_relaxed);
+  snapshot.latency = latency_.Take();
+  snapshot.parse = parse_.Take();
+
+  for (size_t i = 0; i < kPhases.size(); ++i) {
+    snapshot.phases[i] = std::chrono::microseconds{phases_[i].load(std::memory_order_relaxed)};
+  }
+
+  std::lock_guard _{errors_mutex_};
+  snapshot.errors = errors_;
+
+  return snapshot;
+}
+
+EndpointMetrics::Ptr Metrics::Endpoint(std::string_view name) {
+  if (name.empty()) {
+    name = "other";
+  }
+
+  {
+    std::shared_lock _{mutex_};
+
+    if (const auto it = endpoints_.find(name); it != endpoints_.end()) {
+      return it->second;
+    }
+  }
+
+  std::lock_guard _{mutex_};
+
+  auto& endpoint = endpoints_[std::string{name}];
+
+  if (!endpoint) {
+    endpoint = std::make_shared<EndpointMetrics>();
+  }
+
+  return endpoint;
+}
+
+Metrics::Snapshot Metrics::Take() const {
+  Snapshot snapshot;
+
+  std::shared_lock _{mutex_};
+
+  for (const auto& [name, endpoint] : endpoints_) {
+    snapshot.endpoints.emplace(name, endpoint->Take());
+  }
+
+  return snapshot;
+}
+
+std::string Metrics::Prometheus() const {
+  const auto snapshot = Take();
+  const auto& endpoints = snapshot.endpoints;
+
+  std::string out;
+
+  AppendCounter(out, "marzbanpp_requests_total", endpoints, &EndpointMetrics::Snapshot::requests);
+  AppendCounter(out, "marzbanpp_sent_bytes_total", endpoints, &EndpointMetrics::Snapshot::bytes_sent);
+  AppendCounter(out, "marzbanpp_received_bytes_total", endpoints, &EndpointMetrics::Snapshot::bytes_received);
+  AppendCounter(out, "marzbanpp_received_body_bytes_total", endpoints, &EndpointMetrics::Snapshot::body_bytes_received);
+  AppendCounter(out, "marzbanpp_decoded_body_bytes_total", endpoints, &EndpointMetrics::Snapshot::body_bytes_decoded);
+  AppendCounter(out, "marzbanpp_new_connections_total", endpoints, &EndpointMetrics::Snapshot::new_connections);
+
+  out += "# TYPE marzbanpp_errors_total counter\n";
+
+  for (const auto& [endpoint, values] : endpoints) {
+    for (const auto& [status_code, count] : values.errors) {
+      fmt::format_to(
+        std::back_inserter(out),
+        "marzbanpp_errors_total{{endpoint=\"{}\",status=\"{}\"}} {}\n",
+        endpoint,
+        status_code,
+        count);
+    }
+  }
+
+  out += "# TYPE marzbanpp_phase_seconds_total counter\n";
+
+  for (const auto& [endpoint, values] : endpoints) {
+    for (size_t i = 0; i < EndpointMetrics::kPhases.size(); ++i) {
+      fmt::format_to(
+        std::back_inserter(out),
+        "marzbanpp_phase_seconds_total{{endpoint=\"{}\",phase=\"{}\"}} {}\n",
+        endpoint,
+        EndpointMetrics::kPhases[i],
+        Seconds(values.phases[i]));
+    }
+  }
+
+  AppendHistogram(out, "marzbanpp_request_duration_seconds", endpoints, &EndpointMetrics::Snapshot::latency);
+  AppendHistogram(out, "marzbanpp_parse_duration_seconds", endpoints, &EndpointMetrics::Snapshot::parse);
+
+  return out;
+}
+
+}// namespace marzbanpp
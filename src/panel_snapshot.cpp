@@ -0,0 +1,103 @@
+#include "marzbanpp/panel_snapshot.h"
+
+namespace {
+
+constexpr std::string_view kMagic = "MZBNSNAP";
+
+// must be increased when PanelSnapshot or any type inside it changes
+constexpr uint32_t kFormatVersion = 1;
+
+constexpr size_t kHeaderSize = kMagic.size() + sizeof(kFormatVersion);
+
+std::string ReadFile(const std::filesystem::path& path) {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+
+  if (!file) {
+    return {};
+  }
+
+  std::string content(static_cast<size_t>(file.tellg()), '\0');
+
+  file.seekg(0);
+
+  if (!file.read(content.data(), static_cast<std::streamsize>(content.size()))) {
+    throw marzbanpp::SnapshotFormatError{"can't read snapshot " + path.string()};
+  }
+
+  return content;
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+PanelSnapshot TakePanelSnapshot(const IApi& api) {
+  PanelSnapshot snapshot;
+  snapshot.taken_at = static_cast<uint64_t>(
+    std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+
+  IApi::GetUsersParams params;
+  params.sort = "created_at";
+
+  snapshot.users = api.GetUsers(params);
+  snapshot.hosts = api.GetHosts();
+  snapshot.inbounds = api.GetInbounds();
+  snapshot.admins = api.GetAdmins();
+
+  return snapshot;
+}
+
+void SavePanelSnapshot(const PanelSnapshot& snapshot, const std::filesystem::path& path) {
+  std::string buffer{kMagic};
+  buffer.append(reinterpret_cast<const char*>(&kFormatVersion), sizeof(kFormatVersion));
+
+  std::string payload;
+
+  if (const auto error = glz::write_beve(snapshot, payload)) {
+    throw ToObjectFromJsonError{error};
+  }
+
+  buffer += payload;
+
+  auto temporary = path;
+  temporary += ".tmp";
+
+  {
+    std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+
+    if (!file.write(buffer.data(), static_cast<std::streamsize>(buffer.size())) || !file.flush()) {
+      throw SnapshotFormatError{"can't write snapshot " + temporary.string()};
+    }
+  }
+
+  std::filesystem::rename(temporary, path);
+}
+
+std::optional<PanelSnapshot> LoadPanelSnapshot(const std::filesystem::path& path) {
+  const auto content = ReadFile(path);
+
+  if (content.size() < kHeaderSize || !content.starts_with(kMagic)) {
+    if (content.empty()) {
+      return std::nullopt;
+    }
+
+    throw SnapshotFormatError{path.string() + " isn't a panel snapshot"};
+  }
+
+  uint32_t version = 0;
+  std::memcpy(&version, content.data() + kMagic.size(), sizeof(version));
+
+  if (version != kFormatVersion) {
+    return std::nullopt;
+  }
+
+  PanelSnapshot snapshot;
+
+  if (const auto error = glz::read_beve(snapshot, std::string_view{content}.substr(kHeaderSize))) {
+    throw SnapshotFormatError{"damaged snapshot " + path.string() + ": " + glz::format_error(error)};
+  }
+
+  return snapshot;
+}
+
+}// namespace marzbanpp
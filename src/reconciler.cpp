@@ -0,0 +1,259 @@
+#include "marzbanpp/reconciler.h"
+
+#include "marzbanpp/parse_response.h"
+#include "marzbanpp/user_patch.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+ReconcileAction MakeAction(ReconcileAction::Kind kind, const std::string& username) {
+  ReconcileAction action;
+  action.kind = kind;
+  action.username = username;
+
+  return action;
+}
+
+const std::string* DesiredOwner(const User& user) {
+  return user.admin && user.admin->username ? &*user.admin->username : nullptr;
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+std::string ReconcilePlan::Describe() const {
+  std::string description;
+
+  for (const auto& action : actions) {
+    switch (action.kind) {
+      case ReconcileAction::Kind::kAdd:
+        description += fmt::format("+ {}", action.username);
+
+        if (!action.admin_username.empty()) {
+          description += fmt::format(" (owner {})", action.admin_username);
+        }
+
+        break;
+      case ReconcileAction::Kind::kModify:
+        description += fmt::format("~ {}: {}", action.username, fmt::join(action.fields, ", "));
+        break;
+      case ReconcileAction::Kind::kSetOwner:
+        description += fmt::format("> {}: owner {}", action.username, action.admin_username);
+        break;
+      case ReconcileAction::Kind::kRemove:
+        description += fmt::format("- {}", action.username);
+        break;
+    }
+
+    description += '\n';
+  }
+
+  return description;
+}
+
+double Reconciler::Report::ActionsPerSecond() const noexcept {
+  const auto seconds = std::chrono::duration<double>(elapsed).count();
+  const auto actions = added + modified + owners_set + removed + failed.size();
+  return seconds > 0 ? static_cast<double>(actions) / seconds : 0.0;
+}
+
+Reconciler::Reconciler(IApi::Ptr api) : Reconciler{std::move(api), Options{}} {}
+
+Reconciler::Reconciler(IApi::Ptr api, Options options)
+    : api_{std::move(api)},
+      options_{options} {}
+
+ReconcilePlan Reconciler::Plan(std::span<const User> desired) const {
+  return Plan([desired](const IApi::UserCallback& callback) {
+    for (const auto& user : desired) {
+      callback(User{user});
+    }
+  });
+}
+
+ReconcilePlan Reconciler::Plan(const UserSource& desired) const {
+  const auto started = std::chrono::steady_clock::now();
+
+  std::unordered_map<std::string, User> live;
+  api_->StreamUsers({}, [&live](User&& user) {
+    if (user.username) {
+      auto username = *user.username;
+      live.emplace(std::move(username), std::move(user));
+    }
+  });
+
+  ReconcilePlan plan;
+  plan.live = live.size();
+
+  std::unordered_set<std::string> seen;
+
+  desired([&](User&& user) {
+    if (!user.username) {
+      throw UsernameFieldInUserWasNotSet{"'username' field must be set"};
+    }
+
+    if (!seen.insert(*user.username).second) {
+      throw MarzbanppError{"user " + *user.username + " is met twice in the desired state"};
+    }
+
+    ++plan.desired;
+
+    const auto* owner = DesiredOwner(user);
+    const auto found = live.find(*user.username);
+
+    if (found == live.end()) {
+      auto action = MakeAction(ReconcileAction::Kind::kAdd, *user.username);
+      action.admin_username = owner ? *owner : std::string{};
+      action.user = std::move(user);
+      plan.actions.push_back(std::move(action));
+      return;
+    }
+
+    const auto& current = found->second;
+    const auto actions_before = plan.actions.size();
+
+    if (auto patch = MakeUserPatch(current, user); !patch.Empty()) {
+      auto action = MakeAction(ReconcileAction::Kind::kModify, *user.username);
+      action.user = std::move(patch.user);
+      action.fields = std::move(patch.fields);
+      plan.actions.push_back(std::move(action));
+    }
+
+    if (owner && (!DesiredOwner(current) || *DesiredOwner(current) != *owner)) {
+      auto action = MakeAction(ReconcileAction::Kind::kSetOwner, *user.username);
+      action.admin_username = *owner;
+      plan.actions.push_back(std::move(action));
+    }
+
+    if (plan.actions.size() == actions_before) {
+      ++plan.unchanged;
+    }
+  });
+
+  if (options_.remove_missing) {
+    std::vector<std::string_view> missing;
+
+    for (const auto& [username, user] : live) {
+      if (!seen.contains(username)) {
+        missing.push_back(username);
+      }
+    }
+
+    // sorted, so plans of the same states are identical
+    std::ranges::sort(missing);
+
+    for (const auto username : missing) {
+      plan.actions.push_back(MakeAction(ReconcileAction::Kind::kRemove, std::string{username}));
+    }
+  }
+
+  plan.elapsed = std::chrono::steady_clock::now() - started;
+  return plan;
+}
+
+Reconciler::Report Reconciler::Apply(const ReconcilePlan& plan) const {
+  const auto started = std::chrono::steady_clock::now();
+  const auto& actions = plan.actions;
+
+  // actions of one user are run in the plan order by the same worker: ModifyUser and SetOwner
+  // of a user sent concurrently could be applied by the panel in any order
+  std::vector<std::vector<size_t>> jobs;
+  {
+    std::unordered_map<std::string_view, size_t> job_of_user;
+
+    for (size_t i = 0; i < actions.size(); ++i) {
+      const auto [it, inserted] = job_of_user.try_emplace(actions[i].username, jobs.size());
+
+      if (inserted) {
+        jobs.emplace_back();
+      }
+
+      jobs[it->second].push_back(i);
+    }
+  }
+
+  std::vector<std::exception_ptr> errors(actions.size());
+  std::atomic<size_t> requests{0};
+  std::atomic<size_t> next{0};
+
+  const auto perform = [this, &requests](const ReconcileAction& action) {
+    switch (action.kind) {
+      case ReconcileAction::Kind::kAdd:
+        ++requests;
+        api_->AddUser(action.user);
+
+        if (!action.admin_username.empty()) {
+          ++requests;
+          api_->SetOwner(action.username, action.admin_username);
+        }
+
+        break;
+      case ReconcileAction::Kind::kModify:
+        ++requests;
+        api_->ModifyUser(action.username, action.user);
+        break;
+      case ReconcileAction::Kind::kSetOwner:
+        ++requests;
+        api_->SetOwner(action.username, action.admin_username);
+        break;
+      case ReconcileAction::Kind::kRemove:
+        ++requests;
+        CheckResponse(api_->RemoveUser(action.username));
+        break;
+    }
+  };
+
+  const auto worker = [&]() {
+    for (size_t job = next.fetch_add(1, std::memory_order_relaxed); job < jobs.size();
+         job = next.fetch_add(1, std::memory_order_relaxed)) {
+      for (const auto i : jobs[job]) {
+        try {
+          perform(actions[i]);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      }
+    }
+  };
+
+  {
+    const auto threads = std::clamp<size_t>(options_.parallelism, 1, std::max<size_t>(jobs.size(), 1));
+
+    std::vector<std::jthread> workers;
+    workers.reserve(threads - 1);
+
+    for (size_t i = 1; i < threads; ++i) {
+      workers.emplace_back(worker);
+    }
+
+    worker();
+  }
+
+  Report report;
+  report.requests = requests.load();
+
+  for (size_t i = 0; i < actions.size(); ++i) {
+    if (errors[i]) {
+      report.failed.emplace_back(i, std::move(errors[i]));
+      continue;
+    }
+
+    switch (actions[i].kind) {
+      case ReconcileAction::Kind::kAdd: ++report.added; break;
+      case ReconcileAction::Kind::kModify: ++report.modified; break;
+      case ReconcileAction::Kind::kSetOwner: ++report.owners_set; break;
+      case ReconcileAction::Kind::kRemove: ++report.removed; break;
+    }
+  }
+
+  report.elapsed = std::chrono::steady_clock::now() - started;
+  return report;
+}
+
+Reconciler::Report Reconciler::Reconcile(std::span<const User> desired) const {
+  return Apply(Plan(desired));
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,124 @@
+#include "marzbanpp/net/request_limiter.h"
+
+namespace marzbanpp {
+
+TokenBucketLimiter::TokenBucketLimiter(double rate, size_t burst)
+    : rate_{std::max(rate, 1e-3)},
+      burst_{static_cast<double>(std::max<size_t>(burst, 1))},
+      tokens_{burst_},
+      refilled_at_{Clock::now()},
+      waiting_{0} {}
+
+void TokenBucketLimiter::Acquire() {
+  std::unique_lock lock{mutex_};
+  ++waiting_;
+
+  for (;;) {
+    Refill(Clock::now());
+
+    if (tokens_ >= 1) {
+      break;
+    }
+
+    const auto next_token = std::chrono::duration<double>((1 - tokens_) / rate_);
+    condition_.wait_for(lock, next_token);
+  }
+
+  tokens_ -= 1;
+  --waiting_;
+}
+
+bool TokenBucketLimiter::TryAcquire() {
+  std::lock_guard _{mutex_};
+  Refill(Clock::now());
+
+  if (tokens_ < 1) {
+    return false;
+  }
+
+  tokens_ -= 1;
+  return true;
+}
+
+void TokenBucketLimiter::Release(const Outcome&) noexcept {}
+
+double TokenBucketLimiter::Limit() const {
+  return rate_;
+}
+
+size_t TokenBucketLimiter::QueueDepth() const {
+  std::lock_guard _{mutex_};
+  return waiting_;
+}
+
+void TokenBucketLimiter::Refill(Clock::time_point now) {
+  const auto elapsed = std::chrono::duration<double>(now - refilled_at_).count();
+
+  tokens_ = std::min(burst_, tokens_ + elapsed * rate_);
+  refilled_at_ = now;
+}
+
+AimdLimiter::AimdLimiter() : AimdLimiter{Options{}} {}
+
+AimdLimiter::AimdLimiter(const Options& options)
+    : options_{options},
+      limit_{std::clamp(options.initial_limit, options.min_limit, options.max_limit)},
+      in_flight_{0},
+      waiting_{0} {}
+
+void AimdLimiter::Acquire() {
+  std::unique_lock lock{mutex_};
+
+  ++waiting_;
+  condition_.wait(lock, [this] { return HasCapacity(); });
+  --waiting_;
+
+  ++in_flight_;
+}
+
+bool AimdLimiter::TryAcquire() {
+  std::lock_guard _{mutex_};
+
+  if (!HasCapacity()) {
+    return false;
+  }
+
+  ++in_flight_;
+  return true;
+}
+
+void AimdLimiter::Release(const Outcome& outcome) noexcept {
+  {
+    std::lock_guard _{mutex_};
+    --in_flight_;
+
+    const auto now = Clock::now();
+
+    if (outcome.overloaded || outcome.latency > options_.latency_threshold) {
+      if (now - decreased_at_ >= options_.latency_threshold) {
+        limit_ = std::max(options_.min_limit, limit_ * options_.backoff);
+        decreased_at_ = now;
+      }
+    } else {
+      limit_ = std::min(options_.max_limit, limit_ + 1 / limit_);
+    }
+  }
+
+  condition_.notify_all();
+}
+
+double AimdLimiter::Limit() const {
+  std::lock_guard _{mutex_};
+  return limit_;
+}
+
+size_t AimdLimiter::QueueDepth() const {
+  std::lock_guard _{mutex_};
+  return waiting_;
+}
+
+bool AimdLimiter::HasCapacity() const noexcept {
+  return static_cast<double>(in_flight_) + 1 <= limit_;
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,409 @@
+#include "marzbanpp/retrying_api.h"
+
+#include "marzbanpp/types/exceptions.h"
+
+namespace {
+
+// percentile of fewer samples is too noisy to derive hedging delay from
+constexpr size_t kMinLatencySamples = 20;
+
+bool IsTransient(int status_code) noexcept {
+  switch (status_code) {
+    case 429:
+    case 500:
+    case 502:
+    case 503:
+    case 504:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+//
+// Fixed set of threads sending both requests of hedged calls, each one once its deadline has passed.
+// Every hedged call takes at most two threads and RetryingApi admits at most max_hedged_calls of them,
+// so a request never waits for a free thread.
+//
+class RetryingApi::HedgeExecutor final {
+ public:
+  explicit HedgeExecutor(size_t threads) {
+    threads_.reserve(threads);
+
+    for (size_t i = 0; i < threads; ++i) {
+      threads_.emplace_back([this](std::stop_token stop_token) { Run(std::move(stop_token)); });
+    }
+  }
+
+  ~HedgeExecutor() {
+    for (auto& thread : threads_) {
+      thread.request_stop();
+    }
+
+    condition_.notify_all();
+    threads_.clear();
+  }
+
+  void Post(Clock::time_point deadline, std::function<void()> request) {
+    {
+      std::lock_guard _{mutex_};
+      queue_.emplace(deadline, std::move(request));
+    }
+
+    // threads waiting for a later deadline have to notice an earlier one
+    condition_.notify_all();
+  }
+
+ private:
+  void Run(std::stop_token stop_token) {
+    std::unique_lock lock{mutex_};
+
+    while (!stop_token.stop_requested()) {
+      if (queue_.empty()) {
+        condition_.wait(lock, stop_token, [this] { return !queue_.empty(); });
+        continue;
+      }
+
+      if (const auto deadline = queue_.begin()->first; Clock::now() < deadline) {
+        condition_.wait_until(lock, stop_token, deadline, [this, deadline] {
+          return queue_.empty() || queue_.begin()->first < deadline;
+        });
+        continue;
+      }
+
+      auto request = std::move(queue_.begin()->second);
+      queue_.erase(queue_.begin());
+
+      lock.unlock();
+      request();
+      lock.lock();
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable_any condition_;
+  std::multimap<Clock::time_point, std::function<void()>> queue_;
+  std::vector<std::jthread> threads_;
+};
+
+RetryingApi::RetryingApi(IApi::Ptr api) : RetryingApi{std::move(api), Options{}} {}
+
+RetryingApi::RetryingApi(IApi::Ptr api, Options options)
+    : api_{std::move(api)},
+      options_{options},
+      next_latency_{0},
+      hedged_calls_{0} {
+  options_.max_attempts = std::max<size_t>(options_.max_attempts, 1);
+  options_.latency_samples = std::max(options_.latency_samples, kMinLatencySamples);
+  latencies_.reserve(options_.latency_samples);
+
+  if (options_.hedging) {
+    options_.max_hedged_calls = std::max<size_t>(options_.max_hedged_calls, 1);
+    hedges_ = std::make_unique<HedgeExecutor>(options_.max_hedged_calls * 2);
+  }
+}
+
+RetryingApi::~RetryingApi() = default;
+
+void
+RetryingApi::SetAdminToken(const AdminToken& token) {
+  api_->SetAdminToken(token);
+}
+
+Admin
+RetryingApi::GetCurrentAdmin() const {
+  return api_->GetCurrentAdmin();
+}
+
+Admin
+RetryingApi::CreateAdmin(const Admin& admin) const {
+  return api_->CreateAdmin(admin);
+}
+
+Admin
+RetryingApi::ModifyAdmin(const std::string& username, const Admin& admin) const {
+  return api_->ModifyAdmin(username, admin);
+}
+
+Admin
+RetryingApi::RemoveAdmin(const std::string& username) const {
+  return api_->RemoveAdmin(username);
+}
+
+Admins
+RetryingApi::GetAdmins(const GetAdminsParams& params) const {
+  return api_->GetAdmins(params);
+}
+
+System
+RetryingApi::GetSystemStats() const {
+  return Idempotent<System>([](const IApi& api) { return api.GetSystemStats(); });
+}
+
+Inbounds
+RetryingApi::GetInbounds() const {
+  return Idempotent<Inbounds>([](const IApi& api) { return api.GetInbounds(); });
+}
+
+Hosts
+RetryingApi::GetHosts() const {
+  return Idempotent<Hosts>([](const IApi& api) { return api.GetHosts(); });
+}
+
+Hosts
+RetryingApi::ModifyHosts(const Hosts& hosts) const {
+  return api_->ModifyHosts(hosts);
+}
+
+User
+RetryingApi::AddUser(const User& user) const {
+  return api_->AddUser(user);
+}
+
+User
+RetryingApi::GetUser(const std::string& username) const {
+  return Idempotent<User>([username](const IApi& api) { return api.GetUser(username); });
+}
+
+User
+RetryingApi::ModifyUser(const std::string& username, const User& modified_user) const {
+  return api_->ModifyUser(username, modified_user);
+}
+
+HttpClient::Response
+RetryingApi::RemoveUser(const std::string& username) const {
+  return api_->RemoveUser(username);
+}
+
+User
+RetryingApi::ResetUserDataUsage(const std::string& username) const {
+  return api_->ResetUserDataUsage(username);
+}
+
+User
+RetryingApi::RevokeUserSubscription(const std::string& username) const {
+  return api_->RevokeUserSubscription(username);
+}
+
+Users
+RetryingApi::GetUsers(const GetUsersParams& params) const {
+  return Idempotent<Users>([params](const IApi& api) { return api.GetUsers(params); });
+}
+
+std::string
+RetryingApi::GetUsersJson(const GetUsersParams& params) const {
+  return Idempotent<std::string>([params](const IApi& api) { return api.GetUsersJson(params); });
+}
+
+uint64_t
+RetryingApi::StreamUsers(const GetUsersParams& params, const UserCallback& callback) const {
+  // users which have already been passed to the callback can't be taken back, so it isn't retried
+  return api_->StreamUsers(params, callback);
+}
+
+HttpClient::Response
+RetryingApi::ResetUsersDataUsage() const {
+  return api_->ResetUsersDataUsage();
+}
+
+UserUsage
+RetryingApi::GetUserUsage(const std::string& username, const TimePoint& start, const TimePoint& end) const {
+  return Idempotent<UserUsage>([username, start, end](const IApi& api) { return api.GetUserUsage(username, start, end); });
+}
+
+UsersUsage
+RetryingApi::GetUsersUsage(const TimePoint& start, const TimePoint& end, const std::vector<std::string>& admins) const {
+  return Idempotent<UsersUsage>([start, end, admins](const IApi& api) { return api.GetUsersUsage(start, end, admins); });
+}
+
+User
+RetryingApi::SetOwner(const std::string& username, const std::string& admin_username) const {
+  return api_->SetOwner(username, admin_username);
+}
+
+UserList
+RetryingApi::GetExpiredUsers(const ExpiredUsersParams& params) const {
+  return api_->GetExpiredUsers(params);
+}
+
+UserList
+RetryingApi::DeleteExpiredUsers(const ExpiredUsersParams& params) const {
+  return api_->DeleteExpiredUsers(params);
+}
+
+ApiResult<User>
+RetryingApi::TryGetUser(const std::string& username) const {
+  // transient statuses are thrown to be retried by Idempotent, routine ones are returned right away
+  try {
+    return Idempotent<ApiResult<User>>([username](const IApi& api) {
+      auto result = api.TryGetUser(username);
+
+      if (!result && IsTransient(result.error().StatusCode())) {
+        std::move(result.error()).Throw();
+      }
+
+      return result;
+    });
+  } catch (const MarzbanServerResponseError& ex) {
+    return std::unexpected{ApiError::Status(ex.Response())};
+  }
+}
+
+ApiResult<User>
+RetryingApi::TryAddUser(const User& user) const {
+  return api_->TryAddUser(user);
+}
+
+ApiResult<User>
+RetryingApi::TryModifyUser(const std::string& username, const User& modified_user) const {
+  return api_->TryModifyUser(username, modified_user);
+}
+
+ApiResult<void>
+RetryingApi::TryRemoveUser(const std::string& username) const {
+  return api_->TryRemoveUser(username);
+}
+
+std::optional<RetryingApi::Clock::duration> RetryingApi::HedgingDelay() const {
+  std::vector<Clock::duration> latencies;
+
+  {
+    std::lock_guard _{latencies_mutex_};
+
+    if (latencies_.size() < kMinLatencySamples) {
+      return std::nullopt;
+    }
+
+    latencies = latencies_;
+  }
+
+  const auto percentile = std::clamp(options_.hedging_percentile, 0.0, 1.0);
+  const auto nth = latencies.begin() + static_cast<ptrdiff_t>(percentile * static_cast<double>(latencies.size() - 1));
+  std::nth_element(latencies.begin(), nth, latencies.end());
+
+  return std::max(*nth, options_.min_hedging_delay);
+}
+
+template <typename T>
+T RetryingApi::Idempotent(std::function<T(const IApi&)> call) const {
+  for (size_t attempt = 1;; ++attempt) {
+    try {
+      const auto started = Clock::now();
+      const auto hedging_delay = options_.hedging ? HedgingDelay() : std::nullopt;
+
+      T result = hedging_delay ? Hedged(call, *hedging_delay) : call(*api_);
+
+      RecordLatency(Clock::now() - started);
+      return result;
+    } catch (const CurlError&) {
+      if (attempt >= options_.max_attempts) {
+        throw;
+      }
+    } catch (const MarzbanServerResponseError& ex) {
+      if (attempt >= options_.max_attempts || !IsTransient(ex.Response().status_code)) {
+        throw;
+      }
+    }
+
+    std::this_thread::sleep_for(Backoff(attempt));
+  }
+}
+
+template <typename T>
+T RetryingApi::Hedged(const std::function<T(const IApi&)>& call, Clock::duration delay) const {
+  if (hedged_calls_.fetch_add(1, std::memory_order_acq_rel) >= options_.max_hedged_calls) {
+    hedged_calls_.fetch_sub(1, std::memory_order_acq_rel);
+    return call(*api_);
+  }
+
+  struct State {
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::optional<T> value;
+    std::exception_ptr error;
+    size_t running = 2;
+  };
+
+  const auto state = std::make_shared<State>();
+
+  // both requests may still be running when this call returns, so they own everything they use
+  const auto request = [this, state, api = api_, call]() {
+    std::optional<T> value;
+    std::exception_ptr error;
+
+    // the hedge isn't sent if the primary request has already succeeded
+    if (std::unique_lock lock{state->mutex}; !state->value) {
+      lock.unlock();
+
+      try {
+        value.emplace(call(*api));
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+
+    bool last = false;
+
+    {
+      std::lock_guard _{state->mutex};
+
+      if (value && !state->value) {
+        state->value = std::move(value);
+      } else if (error && !state->error) {
+        state->error = std::move(error);
+      }
+
+      last = --state->running == 0;
+    }
+
+    state->condition.notify_all();
+
+    // the call keeps its place until both requests are done, so the executor always has threads for them
+    if (last) {
+      hedged_calls_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+  };
+
+  const auto now = Clock::now();
+  hedges_->Post(now, request);
+  hedges_->Post(now + delay, request);
+
+  std::unique_lock lock{state->mutex};
+  state->condition.wait(lock, [&state]() { return state->value || state->running == 0; });
+
+  if (state->value) {
+    return std::move(*state->value);
+  }
+
+  std::rethrow_exception(state->error);
+}
+
+RetryingApi::Clock::duration RetryingApi::Backoff(size_t attempt) const {
+  thread_local std::mt19937_64 random{std::random_device{}()};
+
+  const auto exponential = std::chrono::duration<double>(options_.initial_backoff)
+                           * std::pow(options_.backoff_multiplier, static_cast<double>(attempt - 1));
+  const auto ceiling = std::min(exponential, std::chrono::duration<double>(options_.max_backoff));
+
+  // full jitter: concurrent callers failed at the same moment don't retry at the same moment
+  std::uniform_real_distribution<double> jitter{0.0, 1.0};
+  return std::chrono::duration_cast<Clock::duration>(ceiling * jitter(random));
+}
+
+void RetryingApi::RecordLatency(Clock::duration latency) const {
+  std::lock_guard _{latencies_mutex_};
+
+  if (latencies_.size() < options_.latency_samples) {
+    latencies_.push_back(latency);
+  } else {
+    latencies_[next_latency_] = latency;
+    next_latency_ = (next_latency_ + 1) % latencies_.size();
+  }
+}
+
+}// namespace marzbanpp
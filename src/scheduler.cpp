@@ -0,0 +1,58 @@
+#include "marzbanpp/coro/scheduler.h"
+
+namespace marzbanpp {
+
+void InlineScheduler::Schedule(std::coroutine_handle<> handle) {
+  handle.resume();
+}
+
+ThreadPoolScheduler::ThreadPoolScheduler(size_t threads) {
+  threads = std::max<size_t>(threads, 1);
+  threads_.reserve(threads);
+
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this](std::stop_token stop_token) { Run(std::move(stop_token)); });
+  }
+}
+
+ThreadPoolScheduler::~ThreadPoolScheduler() {
+  for (auto& thread : threads_) {
+    thread.request_stop();
+  }
+
+  condition_.notify_all();
+  threads_.clear();
+}
+
+void ThreadPoolScheduler::Schedule(std::coroutine_handle<> handle) {
+  {
+    std::lock_guard _{mutex_};
+    queue_.push_back(handle);
+  }
+
+  condition_.notify_one();
+}
+
+void ThreadPoolScheduler::Run(std::stop_token stop_token) {
+  for (;;) {
+    std::coroutine_handle<> handle;
+
+    {
+      std::unique_lock lock{mutex_};
+
+      // queued coroutines are resumed even after stop is requested: dropping their handles would leak the frames
+      condition_.wait(lock, stop_token, [this] { return !queue_.empty(); });
+
+      if (queue_.empty()) {
+        return;
+      }
+
+      handle = queue_.front();
+      queue_.pop_front();
+    }
+
+    handle.resume();
+  }
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,228 @@
+#include "marzbanpp/usage_collector.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+struct UserOwner {
+  std::string username;
+  std::string admin;
+};
+
+std::string NodeName(const UserUsage::Usage& usage) {
+  if (usage.node_name) {
+    return *usage.node_name;
+  }
+
+  return usage.node_id ? std::to_string(*usage.node_id) : std::string{};
+}
+
+std::vector<std::pair<IApi::TimePoint, IApi::TimePoint>> SplitRange(
+  const IApi::TimePoint& start,
+  const IApi::TimePoint& end,
+  std::chrono::seconds chunk) {
+  chunk = std::max(chunk, std::chrono::seconds{1});
+
+  std::vector<std::pair<IApi::TimePoint, IApi::TimePoint>> ranges;
+
+  for (auto from = start; from < end; from += chunk) {
+    ranges.emplace_back(from, std::min(from + chunk, end));
+  }
+
+  return ranges;
+}
+
+//
+// Calls process(index, worker) for every index in [0, count) from 'parallelism' threads,
+// worker is the number of the calling thread.
+//
+void ParallelFor(size_t count, size_t parallelism, const std::function<void(size_t index, size_t worker)>& process) {
+  std::atomic<size_t> next{0};
+
+  const auto work = [&](size_t worker) {
+    for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      process(i, worker);
+    }
+  };
+
+  const auto threads = std::clamp<size_t>(parallelism, 1, std::max<size_t>(count, 1));
+
+  std::vector<std::jthread> workers;
+  workers.reserve(threads - 1);
+
+  for (size_t i = 1; i < threads; ++i) {
+    workers.emplace_back(work, i);
+  }
+
+  work(0);
+}
+
+void Merge(UsageCollector::Report& into, UsageCollector::Report&& from) {
+  for (auto& [username, traffic] : from.per_user) {
+    into.per_user[username] += traffic;
+  }
+
+  for (auto& [node, traffic] : from.per_node) {
+    into.per_node[node] += traffic;
+  }
+
+  for (auto& [admin, traffic] : from.per_admin) {
+    into.per_admin[admin] += traffic;
+  }
+
+  into.total += from.total;
+  into.requests += from.requests;
+  into.failed.insert(
+    into.failed.end(),
+    std::make_move_iterator(from.failed.begin()),
+    std::make_move_iterator(from.failed.end()));
+}
+
+bool EndpointMissing(const MarzbanServerResponseError& error) {
+  return error.Response().status_code == 404 || error.Response().status_code == 405;
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+UsageCollector::UsageCollector(IApi::Ptr api) : UsageCollector{std::move(api), Options{}} {}
+
+UsageCollector::UsageCollector(IApi::Ptr api, Options options)
+    : api_{std::move(api)},
+      options_{std::move(options)},
+      aggregate_unavailable_{false} {}
+
+UsageCollector::Report UsageCollector::Collect(const TimePoint& start, const TimePoint& end) const {
+  const auto until = end == TimePoint{}
+                       ? std::chrono::time_point_cast<std::chrono::seconds>(std::chrono::system_clock::now())
+                       : end;
+
+  if (!options_.per_user && !aggregate_unavailable_.load(std::memory_order_relaxed)) {
+    if (auto report = CollectAggregated(start, until)) {
+      return std::move(*report);
+    }
+  }
+
+  return CollectPerUser(start, until);
+}
+
+std::optional<UsageCollector::Report> UsageCollector::CollectAggregated(const TimePoint& start, const TimePoint& end) const {
+  Report report;
+  report.aggregated = true;
+
+  try {
+    for (const auto& usage : api_->GetUsersUsage(start, end).usages) {
+      const auto traffic = usage.used_traffic.value_or(0);
+
+      report.per_node[NodeName(usage)] += traffic;
+      report.total += traffic;
+    }
+  } catch (const MarzbanServerResponseError& error) {
+    if (!EndpointMissing(error)) {
+      throw;
+    }
+
+    aggregate_unavailable_.store(true, std::memory_order_relaxed);
+    return std::nullopt;
+  }
+
+  const auto admins = api_->GetAdmins();
+  std::vector<uint64_t> admin_traffic(admins.size(), 0);
+  std::vector<std::exception_ptr> errors(admins.size());
+
+  ParallelFor(admins.size(), options_.parallelism, [&](size_t index, size_t) {
+    if (!admins[index].username) {
+      return;
+    }
+
+    try {
+      for (const auto& usage : api_->GetUsersUsage(start, end, {*admins[index].username}).usages) {
+        admin_traffic[index] += usage.used_traffic.value_or(0);
+      }
+    } catch (...) {
+      errors[index] = std::current_exception();
+    }
+  });
+
+  report.requests = 2 + admins.size();
+
+  uint64_t owned = 0;
+
+  for (size_t i = 0; i < admins.size(); ++i) {
+    if (errors[i]) {
+      report.failed.emplace_back(*admins[i].username, std::move(errors[i]));
+      continue;
+    }
+
+    if (admins[i].username) {
+      report.per_admin[*admins[i].username] = admin_traffic[i];
+      owned += admin_traffic[i];
+    }
+  }
+
+  // traffic of failed admins is unknown, so it can't be told apart from the traffic of users without owner
+  if (report.failed.empty() && report.total > owned) {
+    report.per_admin[""] = report.total - owned;
+  }
+
+  return report;
+}
+
+UsageCollector::Report UsageCollector::CollectPerUser(const TimePoint& start, const TimePoint& end) const {
+  std::vector<UserOwner> owners;
+
+  // streamed, so only names are kept in memory even for very large panels
+  api_->StreamUsers({}, [&owners](User&& user) {
+    if (!user.username) {
+      return;
+    }
+
+    auto admin = user.admin && user.admin->username ? std::move(*user.admin->username) : std::string{};
+    owners.push_back({std::move(*user.username), std::move(admin)});
+  });
+
+  const auto ranges = SplitRange(start, end, options_.chunk);
+  const auto jobs = owners.size() * ranges.size();
+  const auto threads = std::clamp<size_t>(options_.parallelism, 1, std::max<size_t>(jobs, 1));
+
+  // every thread sums into its own report, they are merged once at the end
+  std::vector<Report> partial(threads);
+
+  ParallelFor(jobs, threads, [&](size_t index, size_t worker) {
+    const auto& owner = owners[index / ranges.size()];
+    const auto& [from, to] = ranges[index % ranges.size()];
+    auto& report = partial[worker];
+
+    ++report.requests;
+
+    try {
+      uint64_t user_traffic = 0;
+
+      for (const auto& usage : api_->GetUserUsage(owner.username, from, to).usages) {
+        const auto traffic = usage.used_traffic.value_or(0);
+
+        report.per_node[NodeName(usage)] += traffic;
+        user_traffic += traffic;
+      }
+
+      report.per_user[owner.username] += user_traffic;
+      report.per_admin[owner.admin] += user_traffic;
+      report.total += user_traffic;
+    } catch (...) {
+      report.failed.emplace_back(owner.username, std::current_exception());
+    }
+  });
+
+  Report report;
+  report.per_user.reserve(owners.size());
+
+  for (auto& part : partial) {
+    Merge(report, std::move(part));
+  }
+
+  return report;
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,257 @@
+#include "marzbanpp/user_mirror.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+// new users are appended to the end, so pages before them stay the same
+constexpr auto kSortByCreation = "created_at";
+
+UserMirror::Signal MakeSignal(const System& system) {
+  UserMirror::Signal signal;
+  signal.total_user = system.total_user.value_or(0);
+  signal.users_active = system.users_active.value_or(0);
+  signal.users_on_hold = system.users_on_hold.value_or(0);
+  signal.users_disabled = system.users_disabled.value_or(0);
+  signal.users_expired = system.users_expired.value_or(0);
+  signal.users_limited = system.users_limited.value_or(0);
+
+  return signal;
+}
+
+//
+// True when the difference between signals can be explained by newly added users only:
+// nobody has been removed or has changed status.
+//
+bool OnlyUsersAdded(const UserMirror::Signal& previous, const UserMirror::Signal& current) {
+  return current.total_user > previous.total_user
+         && current.users_active >= previous.users_active
+         && current.users_on_hold >= previous.users_on_hold
+         && current.users_disabled >= previous.users_disabled
+         && current.users_expired >= previous.users_expired
+         && current.users_limited >= previous.users_limited;
+}
+
+size_t CompletePages(const UserMirror::Snapshot& snapshot, uint64_t page_size) {
+  size_t pages = 0;
+
+  while (pages < snapshot.pages.size() && snapshot.pages[pages]->users.size() == page_size) {
+    ++pages;
+  }
+
+  return pages;
+}
+
+void IndexUsers(UserMirror::Snapshot& snapshot) {
+  for (const auto& page : snapshot.pages) {
+    for (const auto& user : page->users) {
+      if (user.username) {
+        snapshot.by_username.emplace(*user.username, &user);
+      }
+    }
+  }
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+const User* UserMirror::Snapshot::Find(std::string_view username) const {
+  const auto it = by_username.find(username);
+  return it == by_username.end() ? nullptr : it->second;
+}
+
+UserMirror::UserMirror(IApi::Ptr api) : UserMirror{std::move(api), Options{}} {}
+
+UserMirror::UserMirror(IApi::Ptr api, Options options)
+    : api_{std::move(api)},
+      options_{std::move(options)},
+      synced_at_{0} {
+  options_.page_size = std::max<uint64_t>(options_.page_size, 1);
+
+  Refresh();
+
+  loop_ = std::jthread{[this](std::stop_token stop_token) { Run(std::move(stop_token), options_.refresh_interval); }};
+}
+
+UserMirror::UserMirror(IApi::Ptr api, Options options, std::vector<User> users)
+    : api_{std::move(api)},
+      options_{std::move(options)},
+      synced_at_{0} {
+  options_.page_size = std::max<uint64_t>(options_.page_size, 1);
+
+  // the first refresh must be a full resync: the signal of these users is unknown
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->full_synced_at = Clock::now() - options_.full_resync_interval;
+
+  for (size_t offset = 0; offset < users.size(); offset += options_.page_size) {
+    const auto end = std::min<size_t>(offset + options_.page_size, users.size());
+
+    auto page = std::make_shared<Page>();
+    page->users.assign(
+      std::make_move_iterator(users.begin() + static_cast<ptrdiff_t>(offset)),
+      std::make_move_iterator(users.begin() + static_cast<ptrdiff_t>(end)));
+
+    snapshot->pages.push_back(std::move(page));
+  }
+
+  IndexUsers(*snapshot);
+  snapshot_.store(std::move(snapshot), std::memory_order_release);
+
+  loop_ = std::jthread{[this](std::stop_token stop_token) { Run(std::move(stop_token), Clock::duration::zero()); }};
+}
+
+UserMirror::~UserMirror() {
+  loop_.request_stop();
+}
+
+UserMirror::Snapshot::Ptr UserMirror::Current() const {
+  return snapshot_.load(std::memory_order_acquire);
+}
+
+UserMirror::Snapshot::Ptr UserMirror::Current(Clock::duration max_staleness) {
+  if (Staleness() > max_staleness) {
+    std::lock_guard _{refresh_mutex_};
+
+    // somebody else could have refreshed the mirror while we were waiting
+    if (Staleness() > max_staleness) {
+      Synchronize(true);
+    }
+  }
+
+  return Current();
+}
+
+std::optional<User> UserMirror::GetUser(const std::string& username, Clock::duration max_staleness) {
+  const auto snapshot = Current(max_staleness);
+  const auto* user = snapshot->Find(username);
+
+  return user ? std::optional{*user} : std::nullopt;
+}
+
+UserMirror::Clock::duration UserMirror::Staleness() const noexcept {
+  const auto synced_at = Clock::time_point{Clock::duration{synced_at_.load(std::memory_order_acquire)}};
+  return Clock::now() - synced_at;
+}
+
+std::exception_ptr UserMirror::LastError() const {
+  std::lock_guard _{error_mutex_};
+  return last_error_;
+}
+
+void UserMirror::Refresh() {
+  std::lock_guard _{refresh_mutex_};
+  Synchronize(true);
+}
+
+void UserMirror::Synchronize(bool full) {
+  const auto started = Clock::now();
+  const auto signal = MakeSignal(api_->GetSystemStats());
+  const auto previous = Current();
+
+  const bool full_resync = full || !previous || started - previous->full_synced_at >= options_.full_resync_interval;
+
+  // equal counters don't make the mirror fresh: edits of expire, note, traffic etc. don't change them
+  if (!full_resync && signal == previous->signal) {
+    return;
+  }
+
+  size_t first_page = !full_resync && OnlyUsersAdded(previous->signal, signal)
+                        ? CompletePages(*previous, options_.page_size)
+                        : 0;
+
+  // counters can't tell appended users from removed and added ones
+  if (first_page > 0 && !PagesInPlace(*previous, first_page)) {
+    first_page = 0;
+  }
+
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->pages = FetchPages(previous.get(), first_page);
+  snapshot->signal = signal;
+  snapshot->full_synced_at = first_page == 0 ? started : previous->full_synced_at;
+
+  IndexUsers(*snapshot);
+
+  snapshot_.store(std::move(snapshot), std::memory_order_release);
+
+  // pages kept from the previous snapshot are as old as its full sync
+  if (first_page == 0) {
+    synced_at_.store(started.time_since_epoch().count(), std::memory_order_release);
+  }
+}
+
+void UserMirror::Run(std::stop_token stop_token, Clock::duration first_delay) {
+  for (auto delay = first_delay;; delay = options_.refresh_interval) {
+    {
+      std::unique_lock lock{wait_mutex_};
+
+      wait_condition_.wait_for(lock, stop_token, delay, [] { return false; });
+
+      if (stop_token.stop_requested()) {
+        return;
+      }
+    }
+
+    try {
+      {
+        std::lock_guard _{refresh_mutex_};
+        Synchronize(false);
+      }
+
+      std::lock_guard _{error_mutex_};
+      last_error_ = nullptr;
+    } catch (...) {
+      std::lock_guard _{error_mutex_};
+      last_error_ = std::current_exception();
+    }
+  }
+}
+
+bool UserMirror::PagesInPlace(const Snapshot& snapshot, size_t pages) const {
+  const auto& last = snapshot.pages[pages - 1]->users.back();
+
+  // users are ordered by creation, so a removal before the last kept user moves it to a lower offset
+  IApi::GetUsersParams params;
+  params.offset = pages * options_.page_size - 1;
+  params.limit = 1;
+  params.sort = kSortByCreation;
+
+  const auto users = api_->GetUsers(params).users;
+  return users.size() == 1 && users.front().username == last.username;
+}
+
+std::vector<std::shared_ptr<const UserMirror::Page>> UserMirror::FetchPages(
+  const Snapshot* previous,
+  size_t first_page) const {
+  std::vector<std::shared_ptr<const Page>> pages;
+
+  if (previous) {
+    pages.assign(previous->pages.begin(), previous->pages.begin() + first_page);
+  }
+
+  IApi::GetUsersParams params;
+  params.limit = options_.page_size;
+  params.sort = kSortByCreation;
+
+  for (size_t index = first_page;; ++index) {
+    params.offset = index * options_.page_size;
+
+    auto users = api_->GetUsers(params);
+    const auto received = users.users.size();
+
+    if (received > 0) {
+      auto page = std::make_shared<Page>();
+      page->users = std::move(users.users);
+
+      pages.push_back(std::move(page));
+    }
+
+    if (received < options_.page_size || *params.offset + received >= users.total) {
+      break;
+    }
+  }
+
+  return pages;
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,147 @@
+#include "marzbanpp/user_patch.h"
+
+namespace {
+
+using namespace marzbanpp;
+
+template <typename T>
+bool Satisfies(const std::optional<T>& modified, const std::optional<T>& original);
+
+template <typename T>
+bool Satisfies(const T& modified, const T& original) {
+  return modified == original;
+}
+
+// inbounds of one protocol: empty list is the only way to leave them unset, and panel doesn't keep their order
+bool Satisfies(const std::vector<std::string>& modified, const std::vector<std::string>& original) {
+  return modified.empty() || std::is_permutation(modified.begin(), modified.end(), original.begin(), original.end());
+}
+
+bool Satisfies(const User::Proxies::Vless& modified, const User::Proxies::Vless& original) {
+  return Satisfies(modified.flow, original.flow) && Satisfies(modified.id, original.id);
+}
+
+bool Satisfies(const User::Proxies::Shadowsocks& modified, const User::Proxies::Shadowsocks& original) {
+  return Satisfies(modified.password, original.password) && Satisfies(modified.method, original.method);
+}
+
+bool Satisfies(const User::Proxies& modified, const User::Proxies& original) {
+  return Satisfies(modified.vless, original.vless) && Satisfies(modified.shadowsocks, original.shadowsocks);
+}
+
+bool Satisfies(const User::Inbounds& modified, const User::Inbounds& original) {
+  return Satisfies(modified.vless, original.vless) && Satisfies(modified.shadowsocks, original.shadowsocks);
+}
+
+bool Satisfies(const User::ExcludedInbounds& modified, const User::ExcludedInbounds& original) {
+  return Satisfies(modified.vless, original.vless) && Satisfies(modified.shadowsocks, original.shadowsocks);
+}
+
+template <typename T>
+bool Satisfies(const std::optional<T>& modified, const std::optional<T>& original) {
+  return !modified || (original && Satisfies(*modified, *original));
+}
+
+//
+// Value of a field to be sent: modified with its unset nested fields taken from original.
+// Panel replaces nested objects (e.g. proxies) wholesale, so a partial one would reset the rest of it.
+//
+template <typename T>
+std::optional<T> Overlay(const std::optional<T>& modified, const std::optional<T>& original);
+
+template <typename T>
+T Overlay(const T& modified, const T&) {
+  return modified;
+}
+
+User::Proxies::Vless Overlay(const User::Proxies::Vless& modified, const User::Proxies::Vless& original) {
+  User::Proxies::Vless vless;
+  vless.flow = Overlay(modified.flow, original.flow);
+  vless.id = Overlay(modified.id, original.id);
+
+  return vless;
+}
+
+User::Proxies::Shadowsocks Overlay(
+  const User::Proxies::Shadowsocks& modified,
+  const User::Proxies::Shadowsocks& original) {
+  User::Proxies::Shadowsocks shadowsocks;
+  shadowsocks.password = Overlay(modified.password, original.password);
+  shadowsocks.method = Overlay(modified.method, original.method);
+
+  return shadowsocks;
+}
+
+std::vector<std::string> Overlay(const std::vector<std::string>& modified, const std::vector<std::string>& original) {
+  return modified.empty() ? original : modified;
+}
+
+User::Inbounds Overlay(const User::Inbounds& modified, const User::Inbounds& original) {
+  User::Inbounds inbounds;
+  inbounds.vless = Overlay(modified.vless, original.vless);
+  inbounds.shadowsocks = Overlay(modified.shadowsocks, original.shadowsocks);
+
+  return inbounds;
+}
+
+User::ExcludedInbounds Overlay(const User::ExcludedInbounds& modified, const User::ExcludedInbounds& original) {
+  User::ExcludedInbounds excluded_inbounds;
+  excluded_inbounds.vless = Overlay(modified.vless, original.vless);
+  excluded_inbounds.shadowsocks = Overlay(modified.shadowsocks, original.shadowsocks);
+
+  return excluded_inbounds;
+}
+
+User::Proxies Overlay(const User::Proxies& modified, const User::Proxies& original) {
+  User::Proxies proxies;
+  proxies.vless = Overlay(modified.vless, original.vless);
+  proxies.shadowsocks = Overlay(modified.shadowsocks, original.shadowsocks);
+
+  return proxies;
+}
+
+template <typename T>
+std::optional<T> Overlay(const std::optional<T>& modified, const std::optional<T>& original) {
+  if (!modified) {
+    return original;
+  }
+
+  if (!original) {
+    return modified;
+  }
+
+  return Overlay(*modified, *original);
+}
+
+}// namespace
+
+namespace marzbanpp {
+
+UserPatch MakeUserPatch(const User& original, const User& modified) {
+  UserPatch patch;
+  patch.user.username = modified.username ? modified.username : original.username;
+
+  const auto compare = [&](std::string_view name, auto member) {
+    if (!Satisfies(modified.*member, original.*member)) {
+      patch.user.*member = Overlay(modified.*member, original.*member);
+      patch.fields.push_back(name);
+    }
+  };
+
+  compare("proxies", &User::proxies);
+  compare("inbounds", &User::inbounds);
+  compare("excluded_inbounds", &User::excluded_inbounds);
+  compare("expire", &User::expire);
+  compare("data_limit", &User::data_limit);
+  compare("data_limit_reset_strategy", &User::data_limit_reset_strategy);
+  compare("status", &User::status);
+  compare("note", &User::note);
+  compare("on_hold_expire_duration", &User::on_hold_expire_duration);
+  compare("on_hold_timeout", &User::on_hold_timeout);
+  compare("auto_delete_in_days", &User::auto_delete_in_days);
+  compare("next_plan", &User::next_plan);
+
+  return patch;
+}
+
+}// namespace marzbanpp
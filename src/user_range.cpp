@@ -0,0 +1,108 @@
+#include "marzbanpp/user_range.h"
+
+namespace marzbanpp {
+
+UserRange::UserRange(FetchPage fetch_page, IApi::GetUsersParams params, uint64_t page_size, size_t prefetch_depth)
+    : fetch_page_{std::move(fetch_page)},
+      params_{std::move(params)},
+      page_size_{std::max<uint64_t>(page_size, 1)},
+      prefetch_depth_{std::max<size_t>(prefetch_depth, 1)},
+      next_offset_{params_.offset.value_or(0)},
+      index_{0},
+      started_{false},
+      exhausted_{false} {
+  if (params_.limit) {
+    end_offset_ = next_offset_ + *params_.limit;
+  }
+}
+
+UserRange::Iterator UserRange::begin() {
+  if (!started_) {
+    started_ = true;
+
+    // 'total' is unknown yet, so only the first page is requested
+    SchedulePage(end_offset_ ? std::min(page_size_, *end_offset_ - next_offset_) : page_size_);
+    TakeNextPage();
+  }
+
+  return Iterator{this};
+}
+
+std::optional<uint64_t> UserRange::Total() const noexcept {
+  return total_;
+}
+
+User& UserRange::Current() {
+  return page_[index_];
+}
+
+void UserRange::Advance() {
+  ++index_;
+
+  if (index_ >= page_.size()) {
+    TakeNextPage();
+  }
+}
+
+bool UserRange::Done() const noexcept {
+  return started_ && index_ >= page_.size() && pending_.empty();
+}
+
+void UserRange::SchedulePage(uint64_t size) {
+  if (size == 0) {
+    return;
+  }
+
+  auto params = params_;
+  params.offset = next_offset_;
+  params.limit = size;
+
+  pending_.emplace_back(fetch_page_(params), size);
+  next_offset_ += size;
+}
+
+void UserRange::SchedulePages() {
+  while (!exhausted_ && end_offset_ && next_offset_ < *end_offset_ && pending_.size() < prefetch_depth_) {
+    SchedulePage(std::min(page_size_, *end_offset_ - next_offset_));
+  }
+}
+
+void UserRange::TakeNextPage() {
+  page_.clear();
+  index_ = 0;
+
+  while (page_.empty() && !pending_.empty()) {
+    auto [future, requested] = std::move(pending_.front());
+    pending_.pop_front();
+
+    auto users = future.get();
+
+    if (!total_) {
+      total_ = users.total;
+      end_offset_ = end_offset_ ? std::min(*end_offset_, users.total) : users.total;
+    }
+
+    if (users.users.size() < requested) {
+      // users have been removed since 'total' was received, there is nothing behind this page
+      exhausted_ = true;
+      pending_.clear();
+    }
+
+    page_ = std::move(users.users);
+    SchedulePages();
+  }
+}
+
+UserRange IterateUsers(
+  const IApi::Ptr& api,
+  const IApi::GetUsersParams& params,
+  uint64_t page_size,
+  size_t prefetch_depth) {
+  auto fetch_page = [api](const IApi::GetUsersParams& page_params) {
+    return std::async(std::launch::async, [api, page_params]() { return api->GetUsers(page_params); });
+  };
+
+  return UserRange{std::move(fetch_page), params, page_size, prefetch_depth};
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,171 @@
+#include "marzbanpp/user_table.h"
+
+namespace marzbanpp {
+
+UserStatus ParseUserStatus(std::string_view status) noexcept {
+  if (status == status_values::kActive) {
+    return UserStatus::kActive;
+  }
+
+  if (status == status_values::kOnHold) {
+    return UserStatus::kOnHold;
+  }
+
+  if (status == status_values::kDisabled) {
+    return UserStatus::kDisabled;
+  }
+
+  if (status == status_values::kLimited) {
+    return UserStatus::kLimited;
+  }
+
+  if (status == status_values::kExpired) {
+    return UserStatus::kExpired;
+  }
+
+  return UserStatus::kUnknown;
+}
+
+UserTable::UserTable(const std::vector<User>& users) {
+  Reserve(users.size());
+
+  for (const auto& user : users) {
+    Append(user);
+  }
+}
+
+UserTable::UserTable(const Users& users) : UserTable{users.users} {}
+
+void UserTable::Reserve(size_t rows) {
+  expire_.reserve(rows);
+  data_limit_.reserve(rows);
+  used_traffic_.reserve(rows);
+  lifetime_used_traffic_.reserve(rows);
+  status_.reserve(rows);
+  admin_.reserve(rows);
+  username_ends_.reserve(rows);
+}
+
+void UserTable::Append(const User& user) {
+  expire_.push_back(user.expire.value_or(0));
+  data_limit_.push_back(user.data_limit.value_or(0));
+  used_traffic_.push_back(user.used_traffic.value_or(0));
+  lifetime_used_traffic_.push_back(user.lifetime_used_traffic.value_or(0));
+  status_.push_back(user.status ? ParseUserStatus(*user.status) : UserStatus::kUnknown);
+
+  AdminId admin = kNoAdmin;
+
+  if (user.admin && user.admin->username) {
+    const auto [it, inserted] = admin_ids_.try_emplace(*user.admin->username, static_cast<AdminId>(admins_.size() + 1));
+
+    if (inserted) {
+      admins_.push_back(*user.admin->username);
+    }
+
+    admin = it->second;
+  }
+
+  admin_.push_back(admin);
+
+  usernames_ += user.username.value_or("");
+  username_ends_.push_back(static_cast<uint32_t>(usernames_.size()));
+}
+
+std::string_view UserTable::Username(size_t row) const noexcept {
+  const size_t begin = row == 0 ? 0 : username_ends_[row - 1];
+  return std::string_view{usernames_}.substr(begin, username_ends_[row] - begin);
+}
+
+UserTable::AdminId UserTable::FindAdmin(std::string_view username) const noexcept {
+  const auto it = admin_ids_.find(std::string{username});
+  return it == admin_ids_.end() ? kNoAdmin : it->second;
+}
+
+std::string_view UserTable::AdminUsername(AdminId admin) const noexcept {
+  return admin == kNoAdmin || admin > admins_.size() ? std::string_view{} : std::string_view{admins_[admin - 1]};
+}
+
+UserTable::Mask UserTable::StatusIs(UserStatus status) const {
+  return Where(Status(), [status](UserStatus value) { return value == status; });
+}
+
+UserTable::Mask UserTable::OwnedBy(std::string_view admin_username) const {
+  const auto admin = FindAdmin(admin_username);
+
+  if (admin == kNoAdmin) {
+    return Mask(Size(), 0);
+  }
+
+  return Where(Admin(), [admin](AdminId value) { return value == admin; });
+}
+
+UserTable::Mask UserTable::TrafficUsedAtLeast(uint32_t percent) const {
+  Mask mask(Size());
+
+  const uint64_t* limit = data_limit_.data();
+  const uint64_t* used = used_traffic_.data();
+
+  // compared as used * 100 >= limit * percent, so the loop has no division and no branches
+  for (size_t i = 0; i < mask.size(); ++i) {
+    mask[i] = static_cast<uint8_t>((limit[i] != 0) & (used[i] * 100 >= limit[i] * percent));
+  }
+
+  return mask;
+}
+
+UserTable::Mask UserTable::ExpiresBetween(uint64_t from, uint64_t to) const {
+  return Where(Expire(), [from, to](uint64_t expire) { return (expire != 0) & (expire >= from) & (expire < to); });
+}
+
+void UserTable::And(Mask& mask, const Mask& other) noexcept {
+  const size_t size = std::min(mask.size(), other.size());
+
+  for (size_t i = 0; i < size; ++i) {
+    mask[i] &= other[i];
+  }
+}
+
+void UserTable::Or(Mask& mask, const Mask& other) noexcept {
+  const size_t size = std::min(mask.size(), other.size());
+
+  for (size_t i = 0; i < size; ++i) {
+    mask[i] |= other[i];
+  }
+}
+
+size_t UserTable::Count(const Mask& mask) noexcept {
+  size_t count = 0;
+
+  for (const auto selected : mask) {
+    count += selected;
+  }
+
+  return count;
+}
+
+uint64_t UserTable::Sum(std::span<const uint64_t> column, const Mask& mask) noexcept {
+  const size_t size = std::min(column.size(), mask.size());
+  uint64_t sum = 0;
+
+  for (size_t i = 0; i < size; ++i) {
+    // multiplication instead of a branch keeps the loop vectorizable
+    sum += column[i] * mask[i];
+  }
+
+  return sum;
+}
+
+std::vector<uint32_t> UserTable::Rows(const Mask& mask) {
+  std::vector<uint32_t> rows;
+  rows.reserve(Count(mask));
+
+  for (size_t i = 0; i < mask.size(); ++i) {
+    if (mask[i]) {
+      rows.push_back(static_cast<uint32_t>(i));
+    }
+  }
+
+  return rows;
+}
+
+}// namespace marzbanpp
@@ -0,0 +1,233 @@
+#include "marzbanpp/users_stream_parser.h"
+
+#include "marzbanpp/types/exceptions.h"
+
+namespace {
+
+constexpr int kHttpOk = 200;
+
+constexpr std::string_view kUsersKey = "users";
+constexpr std::string_view kTotalKey = "total";
+constexpr std::string_view kWhitespace = " \t\r\n";
+
+}// namespace
+
+namespace marzbanpp {
+
+UsersStreamParser::UsersStreamParser(UserCallback callback)
+    : callback_{std::move(callback)},
+      depth_{0},
+      in_string_{false},
+      escape_{false},
+      expecting_key_{false},
+      collecting_key_{false},
+      in_users_array_{false},
+      done_{false},
+      field_{Field::kOther},
+      capture_{Capture::kNone},
+      capture_begin_{0},
+      parsed_{0} {}
+
+void UsersStreamParser::Feed(std::string_view chunk) {
+  capture_begin_ = 0;
+  size_t position = 0;
+
+  while (position < chunk.size()) {
+    if (in_string_) {
+      position = SkipString(chunk, position);
+      continue;
+    }
+
+    const char symbol = chunk[position];
+
+    switch (symbol) {
+      case '"':
+        in_string_ = true;
+
+        if (depth_ == 1 && expecting_key_) {
+          collecting_key_ = true;
+          key_.clear();
+        }
+
+        break;
+
+      case ':':
+        if (depth_ == 1 && expecting_key_) {
+          expecting_key_ = false;
+
+          if (key_ == kUsersKey) {
+            field_ = Field::kUsers;
+          } else if (key_ == kTotalKey) {
+            field_ = Field::kTotal;
+            BeginCapture(Capture::kTotal, position + 1);
+          } else {
+            field_ = Field::kOther;
+          }
+        }
+
+        break;
+
+      case ',':
+        if (depth_ == 1) {
+          if (capture_ == Capture::kTotal) {
+            EndCapture(chunk, position);
+            OnTotal();
+          }
+
+          expecting_key_ = true;
+        }
+
+        break;
+
+      case '{':
+      case '[':
+        ++depth_;
+
+        if (depth_ == 1) {
+          if (symbol != '{' || done_) {
+            throw MalformedUsersStreamError{"users response must be a single json object"};
+          }
+
+          expecting_key_ = true;
+        } else if (depth_ == 2 && symbol == '[' && field_ == Field::kUsers) {
+          in_users_array_ = true;
+        } else if (depth_ == 3 && symbol == '{' && in_users_array_) {
+          BeginCapture(Capture::kUser, position);
+        }
+
+        break;
+
+      case '}':
+      case ']':
+        if (depth_ == 0) {
+          throw MalformedUsersStreamError{"unbalanced brackets in users response"};
+        }
+
+        if (depth_ == 3 && capture_ == Capture::kUser) {
+          EndCapture(chunk, position + 1);
+          OnUser();
+        } else if (depth_ == 2) {
+          in_users_array_ = false;
+        } else if (depth_ == 1) {
+          if (capture_ == Capture::kTotal) {
+            EndCapture(chunk, position);
+            OnTotal();
+          }
+
+          done_ = true;
+        }
+
+        --depth_;
+        break;
+
+      default:
+        break;
+    }
+
+    ++position;
+  }
+
+  if (capture_ != Capture::kNone) {
+    record_.append(chunk.substr(capture_begin_));
+  }
+}
+
+uint64_t UsersStreamParser::Finish() const {
+  if (!done_ || !total_) {
+    throw MalformedUsersStreamError{"users response is incomplete"};
+  }
+
+  return *total_;
+}
+
+uint64_t UsersStreamParser::Parsed() const noexcept {
+  return parsed_;
+}
+
+size_t UsersStreamParser::SkipString(std::string_view chunk, size_t position) {
+  if (escape_) {
+    escape_ = false;
+
+    if (collecting_key_) {
+      key_ += chunk[position];
+    }
+
+    return position + 1;
+  }
+
+  const size_t special = chunk.find_first_of("\"\\", position);
+  const size_t end = special == std::string_view::npos ? chunk.size() : special;
+
+  if (collecting_key_) {
+    key_.append(chunk.substr(position, end - position));
+  }
+
+  if (special == std::string_view::npos) {
+    return end;
+  }
+
+  if (chunk[special] == '\\') {
+    escape_ = true;
+
+    if (collecting_key_) {
+      key_ += '\\';
+    }
+  } else {
+    in_string_ = false;
+    collecting_key_ = false;
+  }
+
+  return special + 1;
+}
+
+void UsersStreamParser::BeginCapture(Capture capture, size_t position) {
+  capture_ = capture;
+  capture_begin_ = position;
+
+  // capacity is kept, so the buffer is reallocated only for records longer than previous ones
+  record_.clear();
+}
+
+void UsersStreamParser::EndCapture(std::string_view chunk, size_t position) {
+  record_.append(chunk.substr(capture_begin_, position - capture_begin_));
+  capture_ = Capture::kNone;
+}
+
+void UsersStreamParser::OnUser() {
+  auto parsed = glz::read_json<User>(record_);
+
+  if (!parsed) {
+    HttpClient::Response response;
+    response.status_code = kHttpOk;
+    response.body = record_;
+
+    throw FromJsonToObjectError{parsed.error(), response};
+  }
+
+  ++parsed_;
+  callback_(std::move(*parsed));
+}
+
+void UsersStreamParser::OnTotal() {
+  std::string_view value = record_;
+
+  const auto begin = value.find_first_not_of(kWhitespace);
+  const auto end = value.find_last_not_of(kWhitespace);
+
+  if (begin == std::string_view::npos) {
+    throw MalformedUsersStreamError{"'total' field is empty"};
+  }
+
+  value = value.substr(begin, end - begin + 1);
+
+  uint64_t total = 0;
+  const auto [last, error] = std::from_chars(value.data(), value.data() + value.size(), total);
+
+  if (error != std::errc{} || last != value.data() + value.size()) {
+    throw MalformedUsersStreamError{"'total' field is not an unsigned integer: " + std::string{value}};
+  }
+
+  total_ = total;
+}
+
+}// namespace marzbanpp